@@ -0,0 +1,58 @@
+#pragma once
+
+#include "font.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Generates a packed atlas in the background for fonts created with FontConfig::asyncGeneration.
+ *
+ * The font is fully laid out before generation starts, so only the texels are pending. Glyphs are generated in
+ * batches in charset order; after each batch its glyphs are flagged ready and the texture version changes so the
+ * texture can be re-uploaded. Readers must hold `lock_texture()` while reading the texels.
+ */
+class AsyncAtlasGenerator
+{
+public:
+    /* Starts generating `glyphs` into `data`, which must outlive the generator. Caches the result to `cacheFilename` unless empty. */
+    AsyncAtlasGenerator(std::vector<msdf_atlas::GlyphGeometry> glyphs,
+                        const FontConfig& config,
+                        FontData& data,
+                        std::filesystem::path cacheFilename);
+    /* Stops after the batch in flight. */
+    ~AsyncAtlasGenerator();
+
+    AsyncAtlasGenerator(const AsyncAtlasGenerator&) = delete;
+    auto operator=(const AsyncAtlasGenerator&) -> AsyncAtlasGenerator& = delete;
+
+    /* Returns true once the glyph at `glyphPosition` within the glyph table of the FontData has been generated. */
+    auto is_glyph_ready(std::size_t glyphPosition) const -> bool;
+    auto is_finished() const -> bool;
+    /* Blocks until every glyph has been generated. */
+    void wait();
+
+    auto get_texture_version() const -> std::uint64_t;
+    auto lock_texture() -> std::unique_lock<std::mutex>;
+
+private:
+    void run();
+
+    std::vector<msdf_atlas::GlyphGeometry> m_glyphs;
+    std::vector<std::size_t> m_glyphPositions{};  // Position of each glyph within the glyph table of `m_data`.
+    FontConfig m_config;
+    FontData& m_data;
+    std::filesystem::path m_cacheFilename;
+
+    std::unique_ptr<std::atomic<bool>[]> m_glyphReady;
+    std::atomic<bool> m_finished{ false };
+    std::atomic<bool> m_cancelled{ false };
+    std::atomic<std::uint64_t> m_textureVersion{ 0 };
+    std::mutex m_textureMutex{};
+    std::thread m_thread{};
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "font.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+/*
+ * The stages of building a static atlas, in the order they run.
+ *
+ * Loading & packing is cheap and leaves every table of FontData complete except the texels, so a font can be laid
+ * out before its distance fields exist. Edge coloring & generation make up most of the build time.
+ */
+
+/* Expands the charset ranges of `config` into codepoints. */
+auto get_charset_codepoints(const FontConfig& config) -> std::vector<msdf_atlas::unicode_t>;
+
+/*
+ * Loads the charset from `fontData` and packs it. Fills the metrics, glyph & kerning tables of `outData` and
+ * allocates a blank texture. `ft` must not be used by another thread meanwhile.
+ */
+void load_atlas_glyphs(std::span<const std::uint8_t> fontData,
+                       const FontConfig& config,
+                       msdfgen::FreetypeHandle* ft,
+                       std::vector<msdf_atlas::GlyphGeometry>& outGlyphs,
+                       FontData& outData);
+
+/* Applies edge coloring to `glyphs`, which must be the complete list returned by load_atlas_glyphs. */
+void color_atlas_glyphs(std::span<msdf_atlas::GlyphGeometry> glyphs, const FontConfig& config);
+
+/*
+ * Generates the distance fields of `glyphs` straight into the texture of `data`. If `textureMutex` is given it is
+ * held while writing each glyph's texels, so the texture can be read while the remaining glyphs are generated.
+ */
+void generate_atlas_glyphs(std::span<const msdf_atlas::GlyphGeometry> glyphs,
+                           const FontConfig& config,
+                           FontData& data,
+                           std::mutex* textureMutex = nullptr);
+/* As above, into a `width` x `height` texture with the channel count of `config.atlasType`. */
+void generate_atlas_glyphs(std::span<const msdf_atlas::GlyphGeometry> glyphs,
+                           const FontConfig& config,
+                           std::uint8_t* texels,
+                           std::uint32_t width,
+                           std::uint32_t height,
+                           std::mutex* textureMutex = nullptr);
+
+/*
+ * An msdf_atlas AtlasGenerator for DynamicAtlas that generates through generate_atlas_glyphs, so dynamically added
+ * glyphs run on the shared ThreadPool like everything else. Drop-in for ImmediateAtlasGenerator.
+ */
+template <int N>
+class PooledAtlasGenerator
+{
+public:
+    using Storage = msdf_atlas::BitmapAtlasStorage<msdfgen::byte, N>;
+
+    PooledAtlasGenerator() = default;
+    PooledAtlasGenerator(int width, int height) : m_storage(width, height) {}
+
+    void set_config(const FontConfig& config) { m_config = config; }
+
+    void generate(const msdf_atlas::GlyphGeometry* glyphs, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            m_layout.push_back(msdf_atlas::GlyphBox(glyphs[i]));
+        }
+
+        msdfgen::BitmapRef<msdfgen::byte, N> texture = m_storage;
+        generate_atlas_glyphs(
+            { glyphs, std::size_t(count) }, m_config, texture.pixels, std::uint32_t(texture.width), std::uint32_t(texture.height));
+    }
+
+    void rearrange(int width, int height, const msdf_atlas::Remap* remapping, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            m_layout[remapping[i].index].rect.x = remapping[i].target.x;
+            m_layout[remapping[i].index].rect.y = remapping[i].target.y;
+        }
+        m_storage = Storage(m_storage, width, height, remapping, count);
+    }
+
+    void resize(int width, int height) { m_storage = Storage(m_storage, width, height); }
+
+    auto atlasStorage() const -> const Storage& { return m_storage; }
+    auto getLayout() const -> const std::vector<msdf_atlas::GlyphBox>& { return m_layout; }
+
+private:
+    FontConfig m_config{};
+    Storage m_storage{};
+    std::vector<msdf_atlas::GlyphBox> m_layout{};
+};
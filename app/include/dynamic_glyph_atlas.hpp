@@ -0,0 +1,60 @@
+#pragma once
+
+#include "atlas_generator.hpp"
+#include "font.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <span>
+#include <variant>
+#include <vector>
+
+/*
+ * Backs fonts created with GlyphLoading::OnDemand.
+ *
+ * Glyphs are loaded, colored, packed and generated the first time they are requested. The atlas grows (and is
+ * rearranged when that packs better) through msdf_atlas::DynamicAtlas, so the texture only ever holds glyphs that
+ * were actually used. Keeps its own FreeType instance alive and must only be used from one thread at a time.
+ */
+class DynamicGlyphAtlas
+{
+public:
+    DynamicGlyphAtlas(MappedFile fontFile, const FontConfig& config);
+    /* Copies `fontData`, FreeType reads glyphs from it for as long as the atlas lives. */
+    DynamicGlyphAtlas(std::span<const std::uint8_t> fontData, const FontConfig& config);
+    ~DynamicGlyphAtlas();
+
+    DynamicGlyphAtlas(const DynamicGlyphAtlas&) = delete;
+    auto operator=(const DynamicGlyphAtlas&) -> DynamicGlyphAtlas& = delete;
+
+    /*
+     * Adds every codepoint that is neither in `data` yet nor known to be missing from the font as one batch, then
+     * points the glyph, kerning & texture tables of `data` at the updated atlas. Returns true if `data` changed.
+     */
+    auto add_glyphs(std::span<const msdf_atlas::unicode_t> codepoints, FontData& data) -> bool;
+
+    /* Returns true if the font has no glyph for `codepoint`. Only known for codepoints that were requested before. */
+    auto is_missing(msdf_atlas::unicode_t codepoint) const -> bool;
+
+private:
+    template <int N>
+    using Atlas = msdf_atlas::DynamicAtlas<PooledAtlasGenerator<N>>;
+
+    void initialise();
+    void update_font_data(FontData& data);
+
+    FontConfig m_config;
+    unsigned long long m_coloringSeed{};  // Chained between glyphs when coloring without expensiveColoring.
+    MappedFile m_fontFile{};
+    std::vector<std::uint8_t> m_fontBytes{};
+    std::span<const std::uint8_t> m_fontData{};
+
+    std::unique_ptr<msdfgen::FreetypeHandle, void (*)(msdfgen::FreetypeHandle*)> m_freetype;
+    std::unique_ptr<msdfgen::FontHandle, void (*)(msdfgen::FontHandle*)> m_font;
+    msdf_atlas::FontGeometry m_geometry{};
+
+    std::variant<Atlas<3>, Atlas<4>> m_atlas{};
+    std::vector<msdf_atlas::GlyphGeometry> m_glyphs{};  // In the order they were added to the atlas.
+    std::set<msdf_atlas::unicode_t> m_missingCodepoints{};
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Prefix sums of a growing array of values in O(log n) per update & query, also known as a binary indexed tree.
+ *
+ * Each node holds the sum of the values in a range ending at its index, the length of which is the lowest set bit of
+ * the index. Sums are kept in doubles so millions of small values add up without visible drift.
+ */
+class FenwickTree
+{
+public:
+    void push_back(double value);
+    /* Adds `delta` to the value at `index`. */
+    void add(std::size_t index, double delta);
+    void clear() { m_nodes.assign(1, 0.0); }
+
+    auto size() const -> std::size_t { return m_nodes.size() - 1; }
+    /* The sum of the first `count` values. */
+    auto prefix_sum(std::size_t count) const -> double;
+    auto total() const -> double { return prefix_sum(size()); }
+    /* Returns how many values from the start add up to at most `target`, values must not be negative. */
+    auto find(double target) const -> std::size_t;
+
+private:
+    std::vector<double> m_nodes{ 0.0 };  // One based, the first node is unused.
+};
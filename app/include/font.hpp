@@ -1,58 +1,215 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
 #include <vector>
 #include <filesystem>
 
+#include "glyph_table.hpp"
+#include "mapped_file.hpp"
+
 #include <msdf-atlas-gen.h>
 #include <FontGeometry.h>
 
-/* A structure that describes a glyph. */
-struct GlyphInfo
+/* The kind of distance field stored in the atlas. */
+enum class AtlasType : std::uint32_t
+{
+    MSDF,   // Multi-channel signed distance field (RGB).
+    MTSDF,  // MSDF with a true signed distance field in the alpha channel (RGBA).
+};
+
+/* When glyphs are generated. */
+enum class GlyphLoading : std::uint32_t
+{
+    Eager,     // Every codepoint in the charset is generated up front and the atlas never changes.
+    OnDemand,  // The charset is generated up front, any other codepoint the first time it is requested.
+};
+
+/* An inclusive range of Unicode codepoints. */
+struct CharsetRange
+{
+    std::uint32_t begin{};
+    std::uint32_t end{};
+};
+
+/* The parameters an atlas is generated with. Every generation parameter is part of the atlas cache key. */
+struct FontConfig
+{
+    // Taken from ImGui - imgui_draw.cpp (GetGlyphRanges)
+    std::vector<CharsetRange> charsetRanges{
+        { 0x0020, 0x00FF },  // Basic Latin + Latin Supplement
+    };
+
+    AtlasType atlasType{ AtlasType::MSDF };
+    double emSize{ 32.0 };
+    double pixelRange{ 2.0 };  // Shader should use this value
+    double miterLimit{ 1.0 };
+    std::int32_t padding{ 1 };
+    std::uint64_t coloringSeed{ 0 };
+    bool expensiveColoring{ true };
+
+    GlyphLoading glyphLoading{ GlyphLoading::Eager };  // OnDemand atlases change at runtime and are never cached.
+    bool asyncGeneration{ false };  // Eager only: generate the atlas in the background, glyphs become ready in batches.
+    std::filesystem::path cacheDirectory{ "font_cache" };  // Where generated atlases are cached. Empty disables the cache.
+};
+
+/* A glyph as placed in the atlas. Plane bounds are in em units relative to the pen position, atlas bounds are in texels. */
+struct AtlasGlyph
 {
-    int Width;       // Glyphs width in pixels.
-    int Height;      // Glyphs height in pixels.
-    int OffsetX;     // The distance from the origin ("pen position") to the left of the glyph.
-    int OffsetY;     // The distance from the origin to the top of the glyph. This is usally a value < 0.
-    float AdvanceX;  // The distance from the origin to the origin of the next glyph. This is usually a value > 0.
+    std::uint32_t codepoint{};
+    std::int32_t index{};  // The glyphs index within the font. Kerning pairs are keyed by this.
+    double advance{};
+    double planeLeft{};
+    double planeBottom{};
+    double planeRight{};
+    double planeTop{};
+    double atlasLeft{};
+    double atlasBottom{};
+    double atlasRight{};
+    double atlasTop{};
 };
 
-/* A structure that describes a fonts parameters & metrics. */
-struct FontInfo
+/* The kerning adjustment between two glyphs, in em units. */
+struct KerningPair
 {
-    std::uint32_t PixelHeight;  // Size this font was generated with.
-    float Ascender;             // The pixel extents above the baseline in pixels(usually positive).
-    float Descender;            // The extens below the baseline in pixels (usually negative).
-    float LineSpacing;      // The baseline-to-baseline distance. Note: This is usually larger than the sum of the ascender and descender.
-    float LineGap;          // The spacing in pixels between one rows descent and the next rows ascent.
-    float MaxAdvanceWidth;  // This field gives the maximum horizontal cursor advance for all glyphs in the font.
+    std::int32_t first{};   // Glyph index of the left glyph.
+    std::int32_t second{};  // Glyph index of the right glyph.
+    double advance{};
 };
 
 struct FontData
 {
-    std::vector<msdf_atlas::GlyphGeometry> glyphs{};
-    msdf_atlas::FontGeometry geometry{};
+    std::uint64_t key{};  // The atlas cache key this data was generated for.
+    msdfgen::FontMetrics metrics{};
+    double emSize{};      // Pixels per em in the atlas.
+    double pixelRange{};  // Distance field range in atlas pixels.
+    std::span<const AtlasGlyph> glyphs{};    // Sorted by codepoint.
+    std::span<const KerningPair> kerning{};  // Sorted by glyph index pair.
 
     std::uint32_t textureWidth{};
     std::uint32_t textureHeight{};
-    std::vector<std::uint8_t> textureData{};
+    std::uint32_t textureChannels{};
+    std::span<const std::uint8_t> textureData{};
+    std::uint64_t textureVersion{};  // Incremented whenever the texture changes.
+
+    // Backing storage for the tables above. A freshly generated font owns its tables,
+    // a font loaded from a bundle points them straight into the mapped file instead.
+    std::vector<AtlasGlyph> ownedGlyphs{};
+    std::vector<KerningPair> ownedKerning{};
+    std::vector<std::uint8_t> ownedTextureData{};
+    MappedFile mapping{};
 };
 
+/* The size of measured text in pixels. */
+struct TextExtents
+{
+    float width{};   // The widest line, from its origin to the pen position after its last glyph.
+    float height{};  // From the ascender of the first line to the descender of the last.
+    std::uint32_t lineCount{};
+};
+
+/* One line of measured text. */
+struct LineExtents
+{
+    std::size_t begin{};  // Byte offset of the line's first character.
+    std::size_t end{};    // Byte offset past its last character, excluding the line break.
+    float width{};        // In pixels.
+};
+
+class DynamicGlyphAtlas;
+class AsyncAtlasGenerator;
+
 class Font
 {
 public:
-    Font(const std::filesystem::path& fontFilename);
+    Font(const std::filesystem::path& fontFilename, const FontConfig& config = {});
+    /* Loads a font from memory, e.g. a font embedded in the binary. `fontData` only needs to outlive the constructor. */
+    Font(std::span<const std::uint8_t> fontData, const FontConfig& config = {});
+    /* Loads a font from a memory-mapped region, e.g. an asset archive. */
+    Font(const MappedFile& fontFile, const FontConfig& config = {});
+    /* Loads a font from memory using a caller owned FreeType instance, which must not be used by another thread meanwhile. */
+    Font(std::span<const std::uint8_t> fontData, const FontConfig& config, msdfgen::FreetypeHandle* freetype);
     ~Font();
 
+    Font(Font&&) noexcept;
+    auto operator=(Font&&) noexcept -> Font&;
+
+    /* Loads a font from a bundle written by `save_bundle`. The bundle is memory mapped, not parsed or copied. */
+    static auto from_bundle(const std::filesystem::path& bundleFilename) -> Font;
+    /* Writes the generated atlas, metrics, glyph & kerning tables as a bundle. */
+    auto save_bundle(const std::filesystem::path& bundleFilename) const -> bool;
+
     auto get_texture_width() const -> std::uint32_t;
     auto get_texture_height() const -> std::uint32_t;
+    auto get_texture_channels() const -> std::uint32_t;
     auto get_texture_data() const -> const void*;
+    /* Changes whenever glyphs are added to the atlas, the texture must then be re-uploaded. */
+    auto get_texture_version() const -> std::uint64_t;
+    /* Unique to this font for the lifetime of the process, unlike its address, which a later font may reuse. Moves with the font. */
+    auto get_id() const -> std::uint64_t { return m_id; }
+    /* Must be held while reading the texture data of a font whose atlas is generated in the background. */
+    auto lock_texture() -> std::unique_lock<std::mutex>;
 
+    /* Associates the renderer's texture with the atlas, it is handed back to the renderer along with draws using the font. */
     void set_texture_id(void* texture);
+    auto get_texture_id() const -> void*;
+
+    /* Returns the font metrics in em units. */
+    auto get_metrics() const -> const msdfgen::FontMetrics&;
+    /* Returns the metrics as floats, in em units. */
+    auto get_font_info() const -> const FontInfo&;
+    /* Finds a glyph through the runtime glyph table, returns null if the atlas does not contain it. */
+    auto get_glyph_info(msdf_atlas::unicode_t codepoint) const -> const GlyphInfo* { return m_glyphTable.find(codepoint); }
+    /* Returns the kerning adjustment between two glyphs in ems. */
+    auto get_kerning(const GlyphInfo& first, const GlyphInfo& second) const -> float
+    {
+        return m_glyphTable.get_kerning(first.GlyphIndex, second.GlyphIndex);
+    }
+    /*
+     * Measures UTF-8 text laid out at `fontSize` like draw calls do, but only from advances & kerning. Lines are broken
+     * at '\n'. Never generates glyphs or allocates, glyphs not in the atlas are measured as '?'. Exact for Eager fonts,
+     * an OnDemand font only measures the glyphs it generated, so request_glyphs the text first.
+     */
+    auto measure(std::string_view text, float fontSize) const -> TextExtents;
+    /* Like measure, also outputs the extents of the first `lines.size()` lines. */
+    auto measure_lines(std::string_view text, float fontSize, std::span<LineExtents> lines) const -> TextExtents;
+    /* Returns the width of a single line of UTF-8 text in ems. Tabs are measured as spaces, line breaks like any other character. */
+    auto measure_line(std::string_view text) const -> float;
+    /* Returns the pixels per em of text drawn at `fontSize`, which sets the distance from ascender to descender. */
+    auto get_font_scale(float fontSize) const -> float;
+
+    /* Finds a glyph by Unicode codepoint, returns null if the atlas does not contain it. */
+    auto get_glyph(msdf_atlas::unicode_t codepoint) const -> const AtlasGlyph*;
+    /* Outputs the advance between two glyphs with kerning taken into consideration, returns false if either glyph is missing. */
+    auto get_advance(double& advance, msdf_atlas::unicode_t codepoint1, msdf_atlas::unicode_t codepoint2) const -> bool;
+
+    /*
+     * Like get_glyph, but fonts created with GlyphLoading::OnDemand generate the glyph if it is not in the atlas yet.
+     * Generating glyphs invalidates glyph pointers handed out before.
+     */
+    auto request_glyph(msdf_atlas::unicode_t codepoint) -> const AtlasGlyph*;
+    /* Like get_glyph_info, but generates the glyph if needed, see request_glyph. Invalidates GlyphInfo pointers when it does. */
+    auto request_glyph_info(msdf_atlas::unicode_t codepoint) -> const GlyphInfo*;
+    /* Generates every missing glyph of `codepoints` in one batch, which packs better than requesting them one by one. */
+    void request_glyphs(std::span<const msdf_atlas::unicode_t> codepoints);
 
-    auto get_geometry() const -> const msdf_atlas::FontGeometry&;
+    /* Returns false while the glyph is still being generated in the background. Pending glyphs should not be drawn. */
+    auto is_glyph_ready(const AtlasGlyph& glyph) const -> bool;
+    auto is_glyph_ready(const GlyphInfo& glyph) const -> bool;
+    /* Returns true once every glyph of the atlas has been generated. */
+    auto is_atlas_complete() const -> bool;
 
 private:
+    explicit Font(std::unique_ptr<FontData> data);
+
+    static auto allocate_id() -> std::uint64_t;
+
+    std::uint64_t m_id{ allocate_id() };
     std::unique_ptr<FontData> m_data;
+    GlyphTable m_glyphTable{};  // Rebuilt whenever `m_data` changes.
+    std::unique_ptr<DynamicGlyphAtlas> m_dynamicAtlas;
+    std::unique_ptr<AsyncAtlasGenerator> m_asyncAtlas;
     void* m_textureId{ nullptr };
-};
\ No newline at end of file
+};
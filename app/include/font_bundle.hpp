@@ -0,0 +1,34 @@
+#pragma once
+
+#include "font.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+/*
+ * Font bundles.
+ *
+ * A bundle holds everything a Font needs at runtime: metrics, a glyph table sorted by codepoint, a kerning table
+ * sorted by glyph index pair and the atlas texels. Every section is stored in its in-memory layout, so loading a
+ * bundle is a single memory mapping - the runtime tables point straight into the mapped file without any parsing
+ * or copying, and the pages are shared between every process that maps the same bundle.
+ *
+ * Bundles double as the on-disk atlas cache. Cache files are named after the cache key, which hashes the font file
+ * contents together with every generation parameter in FontConfig.
+ */
+
+/* Computes the cache key for an atlas generated from `fontBytes` with `config`. */
+auto compute_atlas_cache_key(std::span<const std::uint8_t> fontBytes, const FontConfig& config) -> std::uint64_t;
+
+/* Returns the path of the cache file for `key` within `cacheDirectory`. */
+auto get_atlas_cache_filename(const std::filesystem::path& cacheDirectory, std::uint64_t key) -> std::filesystem::path;
+
+/*
+ * Maps a bundle and points the tables of `outData` into it. If `key` is non-zero the bundle must have been written
+ * for that key. Returns false if the file is missing, malformed or was written for another key.
+ */
+auto map_font_bundle(const std::filesystem::path& filename, std::uint64_t key, FontData& outData) -> bool;
+
+/* Writes `data` as a bundle. The file is written next to its destination first and then renamed into place. */
+auto write_font_bundle(const std::filesystem::path& filename, const FontData& data) -> bool;
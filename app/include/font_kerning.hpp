@@ -0,0 +1,21 @@
+#pragma once
+
+#include "font.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/*
+ * Reads the horizontal kerning of a font straight from its tables, rather than asking FreeType about every glyph pair.
+ *
+ * Pair adjustments of GPOS `kern` features (formats 1 & 2, also behind extension lookups) are used when the font has
+ * any, otherwise format 0 subtables of the `kern` table, which is all FreeType's kerning looks at.
+ */
+
+/*
+ * Returns the kerning pairs between the glyphs of `glyphIndices` (sorted) in `fontData`, sorted by glyph index pair.
+ * Advances are in ems times `fontScale`, pairs without an adjustment are left out. Malformed tables are ignored.
+ */
+auto load_font_kerning(std::span<const std::uint8_t> fontData, std::span<const std::int32_t> glyphIndices, double fontScale)
+    -> std::vector<KerningPair>;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "font.hpp"
+#include "thread_pool.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <vector>
+
+/*
+ * Loads fonts concurrently on a ThreadPool.
+ *
+ * A FreeType library instance must not be used from several threads at once, so every pool thread lazily creates
+ * one that it keeps for its whole lifetime instead of each Font initialising and tearing down its own.
+ */
+class FontLibrary
+{
+public:
+    explicit FontLibrary(ThreadPool& threadPool = ThreadPool::get_shared());
+
+    FontLibrary(const FontLibrary&) = delete;
+    auto operator=(const FontLibrary&) -> FontLibrary& = delete;
+
+    /* Queues a font for loading. Errors are rethrown by the returned future. */
+    auto load(const std::filesystem::path& fontFilename, const FontConfig& config = {}) -> std::future<Font>;
+    /* Queues every font in `fontFilenames`, returning their futures in the same order. */
+    auto load_all(const std::vector<std::filesystem::path>& fontFilenames, const FontConfig& config = {}) -> std::vector<std::future<Font>>;
+
+    auto get_thread_count() const -> std::uint32_t;
+
+private:
+    ThreadPool& m_threadPool;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "stream_buffer.hpp"
+
+#include <glad/glad.h>
+
+/* Persistently & coherently mapped buffer storage with sync objects as fences. Needs OpenGL 4.4 or ARB_buffer_storage. */
+class GlStreamBufferDevice final : public StreamBufferDevice
+{
+public:
+    /* `target` is what the buffer is bound to while its storage is created, e.g. GL_ARRAY_BUFFER. */
+    explicit GlStreamBufferDevice(GLenum target);
+    ~GlStreamBufferDevice() override;
+
+    auto map_storage(std::size_t size) -> std::uint8_t* override;
+    void release_storage() override;
+
+    auto insert_fence() -> Fence override;
+    void wait_fence(Fence fence) override;
+    void delete_fence(Fence fence) override;
+
+    auto get_buffer() const -> GLuint { return m_buffer; }
+
+private:
+    GLenum m_target{};
+    GLuint m_buffer{};
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "gl_stream_buffer.hpp"
+#include "text_render_backend.hpp"
+
+#include <glad/glad.h>
+
+#include <memory>
+#include <vector>
+
+#define GL_TEXT_INSTANCES_PER_FRAME std::size_t(65536)
+#define GL_TEXT_RETAINED_GRANULARITY 16u  // Retained allocations are rounded up to this many instances.
+
+/*
+ * Draws TextDrawLists with OpenGL 4.4+. Instances are streamed through a persistently mapped StreamBuffer & expanded
+ * into quads by the vertex shader. Atlas textures are created on first use & re-uploaded whenever the font's atlas
+ * changes, the backend owns the texture id of every font it draws.
+ *
+ * TextObjects live in a separate buffer, each in a range of its own that is only rewritten (glBufferSubData) when the
+ * object changes. The buffer grows as needed, ranges are handed out first fit.
+ */
+class GlTextBackend final : public TextRenderBackend
+{
+public:
+    explicit GlTextBackend(std::size_t instancesPerFrame = GL_TEXT_INSTANCES_PER_FRAME);
+    ~GlTextBackend() override;
+
+    GlTextBackend(const GlTextBackend&) = delete;
+    auto operator=(const GlTextBackend&) -> GlTextBackend& = delete;
+
+    void begin_frame() override;
+    void render(const TextDrawList& drawList, std::uint32_t viewportWidth, std::uint32_t viewportHeight) override;
+    void render(std::span<TextObject* const> objects, std::uint32_t viewportWidth, std::uint32_t viewportHeight) override;
+    void end_frame() override;
+    void release(TextObject& object) override;
+
+private:
+    struct AtlasTexture
+    {
+        GLuint texture{};
+        std::uint64_t version{};
+    };
+
+    struct RetainedRange
+    {
+        std::uint32_t first{};
+        std::uint32_t count{};
+    };
+
+    void begin_draws(GLuint vao, std::uint32_t viewportWidth, std::uint32_t viewportHeight);
+    auto update_atlas_texture(Font& font) -> GLuint;
+    auto allocate_retained(std::uint32_t count) -> std::uint32_t;
+    void free_retained(std::uint32_t first, std::uint32_t count);
+    void grow_retained(std::uint32_t minimumCapacity);
+
+    GLuint m_program{};
+    GLint m_projMatrixLocation{ -1 };
+    GLuint m_vao{};
+    GlStreamBufferDevice m_bufferDevice{ GL_ARRAY_BUFFER };
+    std::unique_ptr<StreamBuffer> m_buffer{};
+    std::vector<std::unique_ptr<AtlasTexture>> m_textures{};  // Fonts point their texture id at these.
+
+    GLuint m_retainedVao{};
+    GLuint m_retainedBuffer{};
+    std::uint32_t m_retainedCapacity{};  // In instances.
+    std::vector<RetainedRange> m_retainedFree{};  // Sorted by first, never adjacent.
+};
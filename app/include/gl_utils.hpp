@@ -0,0 +1,12 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+
+GLuint compile_shader(const char* shaderSource, GLenum shaderType);
+GLuint create_shader_program(const std::string& vertexSource, const std::string& fragmentSource);
+
+void update_texture_2d(GLuint texture, std::uint32_t width, std::uint32_t height, const void* data, GLenum format, bool generateMipMaps);
+GLuint create_texture_2d(std::uint32_t width, std::uint32_t height, const void* data, GLenum format, bool generateMipMaps);
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+struct FontData;
+
+/*
+ * Two opposite corners of a glyph's quad, computed once when the atlas is built. Positions are in ems relative to the
+ * pen position on the baseline with y pointing down, so placing a corner is `pen + position * size`.
+ */
+struct GlyphQuad
+{
+    float X0, Y0;  // The corner at the glyph's left & bottom plane bounds.
+    float X1, Y1;  // The corner at the glyph's right & top plane bounds.
+    float U0, V0;  // Texture coordinates of the first corner, normalized to the atlas size.
+    float U1, V1;  // Texture coordinates of the second corner.
+};
+
+/* A structure that describes a glyph, ready to be laid out & drawn. */
+struct GlyphInfo
+{
+    GlyphQuad Quad;
+    float AdvanceX;  // The distance from the origin to the origin of the next glyph in ems, before kerning.
+    std::int32_t GlyphIndex;  // The glyphs index within the font, used to look up kerning.
+    std::uint32_t Codepoint;
+    std::uint32_t AtlasIndex;  // Position of the glyph within the glyph table of the FontData.
+};
+
+/* A structure that describes a fonts parameters & metrics. Distances are in ems. */
+struct FontInfo
+{
+    float EmSize;           // Size in pixels of one em in the atlas this font was generated with.
+    float PixelRange;       // The distance field range in atlas pixels, the shader needs it to compute its screen space range.
+    float Ascender;         // The extents above the baseline (usually positive).
+    float Descender;        // The extents below the baseline (usually negative).
+    float LineSpacing;      // The baseline-to-baseline distance. Note: This is usually larger than the sum of the ascender and descender.
+    float LineGap;          // The spacing between one rows descent and the next rows ascent.
+    float MaxAdvanceWidth;  // The maximum horizontal cursor advance of all glyphs in the atlas.
+};
+
+/*
+ * The runtime lookup tables of a font, rebuilt from its FontData whenever that changes.
+ *
+ * Codepoints below GLYPH_TABLE_DIRECT_SIZE are indexed directly, the rest go through an open addressing hash table.
+ * Kerning is a second open addressing table keyed by glyph index pair. Both tables are flat arrays probed linearly,
+ * so a lookup touches one or two cache lines.
+ */
+class GlyphTable
+{
+public:
+    static constexpr std::uint32_t GLYPH_TABLE_DIRECT_SIZE = 256;  // Basic Latin + Latin-1 Supplement.
+
+    GlyphTable() { m_direct.fill(EMPTY); }
+
+    void build(const FontData& data);
+
+    auto get_info() const -> const FontInfo& { return m_info; }
+
+    /* Returns null if the font has no glyph for `codepoint`. */
+    auto find(std::uint32_t codepoint) const -> const GlyphInfo*
+    {
+        std::uint32_t glyph = EMPTY;
+        if (codepoint < GLYPH_TABLE_DIRECT_SIZE)
+        {
+            glyph = m_direct[codepoint];
+        }
+        else if (!m_slots.empty())
+        {
+            for (auto slot = Hash(codepoint) & m_slotMask;; slot = (slot + 1) & m_slotMask)
+            {
+                if (m_slots[slot].codepoint == codepoint || m_slots[slot].glyph == EMPTY)
+                {
+                    glyph = m_slots[slot].glyph;
+                    break;
+                }
+            }
+        }
+        return glyph == EMPTY ? nullptr : &m_glyphs[glyph];
+    }
+
+    /* Returns the kerning adjustment between two glyph indices in ems, zero if the pair isn't kerned. */
+    auto get_kerning(std::int32_t first, std::int32_t second) const -> float
+    {
+        if (m_kerning.empty())
+        {
+            return 0.0f;
+        }
+
+        const auto key = MakeKey(first, second);
+        for (auto slot = Hash(key) & m_kerningMask;; slot = (slot + 1) & m_kerningMask)
+        {
+            if (m_kerning[slot].key == key)
+            {
+                return m_kerning[slot].advance;
+            }
+            if (m_kerning[slot].key == EMPTY_KEY)
+            {
+                return 0.0f;
+            }
+        }
+    }
+
+private:
+    static constexpr std::uint32_t EMPTY = 0xFFFFFFFFu;
+    static constexpr std::uint64_t EMPTY_KEY = 0xFFFFFFFFFFFFFFFFull;
+
+    struct Slot
+    {
+        std::uint32_t codepoint{ EMPTY };
+        std::uint32_t glyph{ EMPTY };
+    };
+    struct KerningSlot
+    {
+        std::uint64_t key{ EMPTY_KEY };
+        float advance{};
+    };
+
+    // Fibonacci hashing, the high bits are the well mixed ones.
+    static auto Hash(std::uint64_t value) -> std::uint32_t { return std::uint32_t((value * 0x9E3779B97F4A7C15ull) >> 32); }
+    static auto MakeKey(std::int32_t first, std::int32_t second) -> std::uint64_t
+    {
+        return (std::uint64_t(std::uint32_t(first)) << 32) | std::uint32_t(second);
+    }
+
+    FontInfo m_info{};
+    std::vector<GlyphInfo> m_glyphs{};  // In FontData::glyphs order.
+    std::array<std::uint32_t, GLYPH_TABLE_DIRECT_SIZE> m_direct{};
+    std::vector<Slot> m_slots{};
+    std::uint32_t m_slotMask{};
+    std::vector<KerningSlot> m_kerning{};
+    std::uint32_t m_kerningMask{};
+};
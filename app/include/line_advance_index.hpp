@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+class Font;
+
+/*
+ * The caret positions of one line of text, for mapping between x coordinates & characters in O(log n).
+ *
+ * Keeps the advance of every character, kerning with the next one included, & their prefix sums. An edit looks up
+ * only the glyphs it inserts & their neighbours, the positions after it are re-accumulated from the stored advances.
+ * Distances are in ems, multiply by Font::get_font_scale for pixels. Characters are codepoints. Glyphs are looked up
+ * like Font::measure_line does, so the glyphs of an OnDemand font must be requested before they are indexed.
+ */
+class LineAdvanceIndex
+{
+public:
+    /* Indexes the UTF-8 `line`, measured like Font::measure_line. */
+    void build(const Font& font, std::string_view line);
+    /* Replaces `removeCount` characters starting at `first` by the UTF-8 `text`. */
+    void replace(const Font& font, std::size_t first, std::size_t removeCount, std::string_view text);
+
+    auto get_character_count() const -> std::size_t { return m_codepoints.size(); }
+    /* The distance from the origin to the caret in front of `character`, the end of the line past the last one. */
+    auto get_caret_x(std::size_t character) const -> float;
+    auto get_width() const -> float { return m_positions.back(); }
+    /* Returns the caret closest to `x`, from 0 (in front of the first character) to the character count. */
+    auto hit_test(float x) const -> std::size_t;
+
+private:
+    /* Recomputes the advances of [first, end) & the positions from `first` on. */
+    void update(const Font& font, std::size_t first, std::size_t end);
+
+    std::vector<std::uint32_t> m_codepoints{};
+    std::vector<float> m_advances{};         // Per character, including the kerning with the next one.
+    std::vector<float> m_positions{ 0.0f };  // Prefix sums of m_advances, one more than there are characters.
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+/* A read-only memory mapping of a whole file. Pages are shared with every other process mapping the same file. */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+
+    /* Maps `filename`, replacing any previous mapping. Returns false if the file is missing, empty or could not be mapped. */
+    auto open(const std::filesystem::path& filename) -> bool;
+    void close();
+
+    auto is_open() const -> bool { return m_data != nullptr; }
+    auto data() const -> const std::uint8_t* { return m_data; }
+    auto size() const -> std::size_t { return m_size; }
+    auto bytes() const -> std::span<const std::uint8_t> { return { m_data, m_size }; }
+
+private:
+    const std::uint8_t* m_data{ nullptr };
+    std::size_t m_size{};
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Font;
+class TextBatch;
+
+/* How lines narrower than the paragraph are placed. */
+enum class TextAlign : std::uint32_t
+{
+    Left,
+    Center,
+    Right,
+};
+
+/* A line of a paragraph. Offsets are bytes into the paragraph's text. */
+struct ParagraphLine
+{
+    std::size_t begin{};
+    std::size_t end{};   // Past the last character drawn, trailing spaces & the line break are left out.
+    std::size_t next{};  // Where the following line begins.
+    float width{};       // In pixels, without trailing spaces.
+};
+
+/*
+ * Breaks UTF-8 text into lines no wider than a maximum width & keeps the lines between edits.
+ *
+ * Lines break after spaces, at '\n' or "\r\n", or anywhere within a word wider than the paragraph. Tabs are as wide as
+ * a space. Lines are spaced by the font's line height. Glyphs are requested as lines are laid out, so OnDemand fonts
+ * wrap with the advances they draw with. An edit lays lines out again from the line before it & stops as soon as a
+ * line begins where one began before the edit, the lines after that are only moved.
+ */
+class ParagraphLayout
+{
+public:
+    ParagraphLayout(Font& font, float fontSize, float maxWidth, TextAlign align = TextAlign::Left);
+
+    void set_text(std::string_view text);
+    /* Replaces `removeCount` bytes at `offset` by `text`, which must not split a UTF-8 sequence. */
+    void replace(std::size_t offset, std::size_t removeCount, std::string_view text);
+
+    void set_font_size(float fontSize);
+    void set_max_width(float maxWidth);
+    void set_align(TextAlign align) { m_align = align; }
+
+    auto get_text() const -> const std::string& { return m_text; }
+    auto get_lines() const -> const std::vector<ParagraphLine>& { return m_lines; }
+    /* The distance between the tops of two lines in pixels. */
+    auto get_line_height() const -> float;
+    auto get_height() const -> float { return get_line_height() * float(m_lines.size()); }
+    /* The number of lines the last change laid out, as opposed to moved. */
+    auto get_relaid_line_count() const -> std::size_t { return m_relaidLineCount; }
+
+    /* Adds the lines to `batch` with the paragraph's top left corner at `x`, `y`. */
+    void draw(TextBatch& batch, float x, float y, std::uint32_t color) const;
+
+private:
+    /* Lays out the line starting at `begin`, requesting its glyphs from the font. */
+    auto layout_line(std::size_t begin) const -> ParagraphLine;
+    void layout_all();
+
+    Font* m_font{};
+    float m_fontSize{};
+    float m_maxWidth{};
+    TextAlign m_align{};
+    std::string m_text{};
+    std::vector<ParagraphLine> m_lines{};
+    std::size_t m_relaidLineCount{};
+};
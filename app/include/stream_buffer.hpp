@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#define STREAM_BUFFER_FRAME_COUNT 3u
+
+/*
+ * The graphics API calls a StreamBuffer makes. Kept behind an interface so the allocation & fencing logic can run
+ * against a mock, see GlStreamBufferDevice for the OpenGL one.
+ */
+class StreamBufferDevice
+{
+public:
+    using Fence = void*;
+
+    virtual ~StreamBufferDevice() = default;
+
+    /* Creates `size` bytes of storage that stays mapped for writing until release_storage, returns the mapping. */
+    virtual auto map_storage(std::size_t size) -> std::uint8_t* = 0;
+    virtual void release_storage() = 0;
+
+    /* Returns a fence the GPU signals once it has executed every command submitted before it. */
+    virtual auto insert_fence() -> Fence = 0;
+    /* Blocks until the GPU signalled `fence`. */
+    virtual void wait_fence(Fence fence) = 0;
+    virtual void delete_fence(Fence fence) = 0;
+};
+
+/*
+ * Persistently mapped storage for geometry that is rewritten every frame, split into STREAM_BUFFER_FRAME_COUNT regions.
+ *
+ * Each frame writes into its own region, which is fenced when the frame ends. A region is only reused once its fence
+ * is signalled, so the CPU writes while the GPU still reads the previous frames, without the driver reallocating or
+ * copying anything.
+ */
+class StreamBuffer
+{
+public:
+    /* Memory stays mapped until the buffer is destroyed, `device` must outlive it. */
+    StreamBuffer(StreamBufferDevice& device, std::size_t frameSize);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    auto operator=(const StreamBuffer&) -> StreamBuffer& = delete;
+
+    /* Moves on to the next region, waiting for the GPU if it still reads from it. Must be called before reserving. */
+    void begin_frame();
+    /* Fences the region written since begin_frame. */
+    void end_frame();
+
+    /*
+     * Returns `size` bytes of the current region at an offset that is a multiple of `alignment`, or null if the region
+     * is full. Nothing is allocated until commit, so the caller may reserve the most it could write.
+     */
+    auto reserve(std::size_t size, std::size_t alignment = 1) -> std::uint8_t*;
+    /* Allocates the first `size` bytes of the last reservation. */
+    void commit(std::size_t size);
+
+    /* The offset of the last reservation from the start of the storage, as the GPU sees it. */
+    auto get_reserved_offset() const -> std::size_t { return m_reservedOffset; }
+    /* The offset of the current region from the start of the storage. */
+    auto get_frame_offset() const -> std::size_t { return m_frame * m_frameSize; }
+    /* The number of bytes committed to the current region. */
+    auto get_frame_used() const -> std::size_t { return m_offset - get_frame_offset(); }
+    auto get_frame_size() const -> std::size_t { return m_frameSize; }
+
+private:
+    StreamBufferDevice& m_device;
+    std::uint8_t* m_storage{ nullptr };
+    std::size_t m_frameSize{};
+    std::uint32_t m_frame{ STREAM_BUFFER_FRAME_COUNT - 1 };  // begin_frame moves on to the first region.
+    std::size_t m_offset{};          // The end of the last commit, from the start of the storage.
+    std::size_t m_reservedOffset{};  // Where the last reservation starts.
+    std::size_t m_reservedSize{};
+    std::array<StreamBufferDevice::Fence, STREAM_BUFFER_FRAME_COUNT> m_fences{};  // One per region, null if it isn't in flight.
+};
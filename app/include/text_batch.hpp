@@ -0,0 +1,65 @@
+#pragma once
+
+#include "text_draw_list.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+class Font;
+
+/*
+ * Collects the text of a frame, so it can be uploaded at once & drawn with one call per atlas instead of one per string.
+ *
+ * Strings are laid out as they are added, each becoming a command with a sort key of shader, atlas & scissor rect.
+ * build_draw_list sorts the commands, so every key ends up a single draw. The batch never touches the GPU and a batch
+ * per thread can lay out text concurrently.
+ *
+ * Glyphs are culled against the viewport & the scissor rect as they are added. Hidden lines & glyphs never become
+ * instances, and glyphs on an edge are cut to it.
+ */
+class TextBatch
+{
+public:
+    void add_text(Font& font, float x, float y, std::string_view text, float fontSize, std::uint32_t color);
+    /* Adds a run laid out at the origin, e.g. by a TextRunCache, moved to `x`, `y` rounded to whole pixels. */
+    void add_run(Font& font, std::span<const GlyphInstance> run, float x, float y, std::uint32_t color);
+
+    /* Culls the text added from now on to a viewport of `width` by `height` pixels. Kept when the batch is cleared. */
+    void set_viewport(std::int32_t width, std::int32_t height);
+    /* Clips the text added from now on to `rect`. */
+    void set_scissor(const ScissorRect& rect);
+    void reset_scissor();
+
+    /*
+     * Sorts the commands added so far & writes them to `out` as draws, replacing its contents. The instances are moved
+     * to `out` rather than copied, which leaves the batch empty.
+     */
+    void build_draw_list(TextDrawList& out);
+
+    /* Empties the batch but keeps its memory, so a batch reused every frame stops allocating. */
+    void clear();
+
+    auto get_instance_count() const -> std::size_t { return m_instances.size(); }
+
+private:
+    struct Command
+    {
+        std::uint64_t sortKey{};
+        std::uint32_t firstInstance{};  // Into m_instances.
+        std::uint32_t instanceCount{};
+    };
+
+    void add_command(Font& font, std::uint32_t firstInstance);
+    auto get_font_slot(Font& font) -> std::uint32_t;
+    void update_clip();
+
+    std::vector<GlyphInstance> m_instances{};  // In the order strings were added.
+    std::vector<Command> m_commands{};
+    std::vector<Font*> m_fonts{};
+    std::vector<ScissorRect> m_scissors{};
+    std::uint32_t m_scissor{ TEXT_NO_SCISSOR };
+    TextClipRect m_viewport{};
+    TextClipRect m_clip{};  // The viewport cut to the scissor rect.
+};
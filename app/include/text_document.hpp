@@ -0,0 +1,62 @@
+#pragma once
+
+#include "fenwick_tree.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Font;
+class TextBatch;
+
+/*
+ * A document of many lines, e.g. a log, that only lays out the lines in view.
+ *
+ * Keeps every line's height in a FenwickTree, so the line at a scroll offset is found in O(log n) and drawing costs
+ * the visible lines only, however long the document gets. Lines are measured once when set, for the document's width,
+ * with Font::measure_line, so an OnDemand font's widths only count glyphs it generated by then.
+ * Lines are one font line high unless given another height, e.g. by wrapping them with a ParagraphLayout.
+ */
+class TextDocument
+{
+public:
+    TextDocument(Font& font, float fontSize);
+
+    /* Adds a line to the end, `text` should not contain '\n'. */
+    void append_line(std::string_view text);
+    void set_line(std::size_t index, std::string_view text);
+    /* Sets the height of a line in pixels. */
+    void set_line_height(std::size_t index, float height);
+    void clear();
+
+    auto get_line_count() const -> std::size_t { return m_lines.size(); }
+    auto get_line(std::size_t index) const -> const std::string& { return m_lines[index]; }
+    /* The distance from the top of the document to the top of the line, in pixels. */
+    auto get_line_top(std::size_t index) const -> float { return float(m_heights.prefix_sum(index)); }
+    auto get_line_height(std::size_t index) const -> float { return m_lineHeights[index]; }
+    /* Returns the line at `y` pixels from the top, clamped to the first & last line. */
+    auto find_line(float y) const -> std::size_t;
+
+    auto get_width() const -> float { return m_width; }
+    auto get_height() const -> float { return float(m_heights.total()); }
+
+    /*
+     * Adds the lines overlapping [scrollY, scrollY + viewHeight) to `batch`, with the top of the view at `x`, `y`.
+     * Returns the number of lines drawn.
+     */
+    auto draw(TextBatch& batch, float x, float y, float scrollY, float viewHeight, std::uint32_t color) const -> std::size_t;
+
+private:
+    void update_width();
+
+    Font* m_font{};
+    float m_fontSize{};
+    float m_defaultLineHeight{};
+    std::vector<std::string> m_lines{};
+    std::vector<float> m_lineWidths{};
+    std::vector<float> m_lineHeights{};
+    FenwickTree m_heights{};
+    float m_width{};  // The widest line.
+};
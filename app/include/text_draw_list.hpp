@@ -0,0 +1,75 @@
+#pragma once
+
+#include "text_instances.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+class Font;
+
+#define TEXT_NO_SCISSOR 0xFFFFFFFFu
+
+/* A rectangle in pixels, relative to the top left corner of the viewport. */
+struct ScissorRect
+{
+    std::int32_t x{};
+    std::int32_t y{};
+    std::int32_t width{};
+    std::int32_t height{};
+
+    auto operator==(const ScissorRect&) const -> bool = default;
+};
+
+/* Consecutive instances of TextDrawList::instances. */
+struct TextInstanceRange
+{
+    std::uint32_t first{};
+    std::uint32_t count{};
+};
+
+/* A run of instances drawn with one atlas & scissor rect, as one instanced draw call. */
+struct TextDraw
+{
+    std::uint32_t atlas{};                      // Into TextDrawList::atlases.
+    std::uint32_t scissor{ TEXT_NO_SCISSOR };   // Into TextDrawList::scissors.
+    std::uint32_t firstRange{};                 // Into TextDrawList::ranges.
+    std::uint32_t rangeCount{};
+    std::uint32_t firstInstance{};              // Where the draw's instances start once its ranges are uploaded.
+    std::uint32_t instanceCount{};
+};
+
+/*
+ * Everything a backend needs to draw a frame's text, as plain data. The glyph quads are expanded from their instance
+ * by the backend, so there are no indices. Built by TextBatch, consumed by a TextRenderBackend.
+ *
+ * Instances stay in the order they were laid out. Backends upload the ranges in order, which puts every draw's
+ * instances next to each other, so sorting them costs no copy besides the upload.
+ */
+struct TextDrawList
+{
+    std::vector<GlyphInstance> instances{};
+    std::vector<TextInstanceRange> ranges{};  // By draw, every draw's ranges follow the previous draw's.
+    std::vector<TextDraw> draws{};
+    std::vector<Font*> atlases{};  // The fonts whose atlas a draw samples, the backend uploads their textures.
+    std::vector<ScissorRect> scissors{};
+
+    /* Copies the instances of `draw` to `out`, which must have room for its instance count. */
+    void gather(const TextDraw& draw, GlyphInstance* out) const
+    {
+        for (auto range = draw.firstRange; range < draw.firstRange + draw.rangeCount; ++range)
+        {
+            std::memcpy(out, instances.data() + ranges[range].first, sizeof(GlyphInstance) * ranges[range].count);
+            out += ranges[range].count;
+        }
+    }
+
+    void clear()
+    {
+        instances.clear();
+        ranges.clear();
+        draws.clear();
+        atlases.clear();
+        scissors.clear();
+    }
+};
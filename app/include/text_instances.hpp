@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+class Font;
+
+/*
+ * One glyph as drawn by the instanced text shader, which expands it into a quad. 20 bytes, where the same glyph as two
+ * triangles of position/color/texture coordinate vertices takes 216.
+ */
+struct GlyphInstance
+{
+    std::int16_t x, y;              // Top left corner of the quad in pixels.
+    std::uint16_t width, height;    // Size of the quad in pixels.
+    std::uint16_t u0, v0, u1, v1;   // Texture coordinates of the left & bottom and the right & top corner, normalized to 0-65535.
+    std::uint32_t color;            // RGBA8, red in the lowest byte.
+};
+static_assert(sizeof(GlyphInstance) == 20, "GlyphInstance is uploaded as is, the vertex layout depends on its size.");
+
+/* A rectangle glyphs are cut to, in pixels, with the right & bottom edges exclusive. Clips nothing by default. */
+struct TextClipRect
+{
+    std::int32_t left{ -32768 };
+    std::int32_t top{ -32768 };
+    std::int32_t right{ 32768 };
+    std::int32_t bottom{ 32768 };
+};
+
+/* Packs a color with components in [0, 1] into the RGBA8 layout of GlyphInstance::color. */
+auto pack_color(float r, float g, float b, float a) -> std::uint32_t;
+
+/*
+ * Lays out the UTF-8 `text` as a single line with its top left corner at `x`, `y` and writes a GlyphInstance per
+ * visible glyph to `out`, which must have room for one per byte of `text`. Codepoints the font lacks are drawn as '?',
+ * tabs as spaces. Glyphs without a quad (spaces) and glyphs still being generated are skipped, but keep their advance.
+ * Only touches the font's glyph table, so it runs without a GPU. Returns the number of instances written.
+ *
+ * With a `clip` rect, a line that can't reach it is rejected before any glyph is looked up, the line stops at the
+ * rect's right edge, and each glyph is cut with clip_glyph_instance.
+ */
+auto write_text_instances(GlyphInstance* out, Font& font, float x, float y, std::string_view text, float fontSize, std::uint32_t color,
+                          const TextClipRect* clip = nullptr) -> std::size_t;
+
+/* Like write_text_instances, but appends the instances to `instances`. */
+auto append_text_instances(std::vector<GlyphInstance>& instances, Font& font, float x, float y, std::string_view text, float fontSize,
+                           std::uint32_t color, const TextClipRect* clip = nullptr) -> std::size_t;
+
+/*
+ * Cuts `instance` to `clip`, moving the texture coordinates of the cut edges so the visible part of the glyph stays
+ * where it was. Returns false, leaving the instance as is, if no part of it is inside.
+ */
+auto clip_glyph_instance(GlyphInstance& instance, const TextClipRect& clip) -> bool;
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "text_instances.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Font;
+class TextRenderBackend;
+
+/* Where a TextObject's instances live in the retained buffer of the backend that draws it. Managed by that backend. */
+struct RetainedTextAllocation
+{
+    TextRenderBackend* backend{};  // Null until the object is first drawn.
+    std::uint32_t firstInstance{};
+    std::uint32_t capacity{};  // In instances, may exceed the instance count so small edits don't move the object.
+    std::uint64_t version{};   // The object version uploaded last.
+};
+
+/*
+ * A string that keeps its laid out glyphs between frames, for text that rarely changes.
+ *
+ * Setters only mark what changed. update, called by the backend when drawing, lays the string out again if the text,
+ * font, size or position changed, or the font's atlas did. A color change only rewrites colors and a move by whole
+ * pixels only shifts the glyphs. Backends upload an object's instances when its version changed, so static text costs
+ * nothing per frame.
+ */
+class TextObject
+{
+public:
+    TextObject() = default;
+    TextObject(Font& font, std::string_view text, float fontSize, std::uint32_t color, float x, float y);
+    /* Gives the object's allocation back to its backend, which must still exist. */
+    ~TextObject();
+
+    TextObject(TextObject&& other) noexcept;
+    auto operator=(TextObject&& other) noexcept -> TextObject&;
+    TextObject(const TextObject&) = delete;
+    auto operator=(const TextObject&) -> TextObject& = delete;
+
+    void set_font(Font& font);
+    void set_text(std::string_view text);
+    void set_font_size(float fontSize);
+    void set_color(std::uint32_t color);
+    /* Moves the top left corner of the text to `x`, `y`. */
+    void set_position(float x, float y);
+
+    /* Brings the instances up to date, returns true if they changed. */
+    auto update() -> bool;
+
+    auto get_font() const -> Font* { return m_font; }
+    auto get_text() const -> const std::string& { return m_text; }
+    auto get_instances() const -> std::span<const GlyphInstance> { return m_instances; }
+    /* Incremented whenever the instances change. */
+    auto get_version() const -> std::uint64_t { return m_version; }
+
+    auto get_allocation() -> RetainedTextAllocation& { return m_allocation; }
+    auto get_allocation() const -> const RetainedTextAllocation& { return m_allocation; }
+
+private:
+    static constexpr std::uint32_t DIRTY_LAYOUT = 1u << 0;
+    static constexpr std::uint32_t DIRTY_COLOR = 1u << 1;
+
+    void release();
+
+    Font* m_font{ nullptr };
+    std::string m_text{};
+    float m_fontSize{};
+    std::uint32_t m_color{};
+    float m_x{};
+    float m_y{};
+
+    std::vector<GlyphInstance> m_instances{};
+    std::uint32_t m_dirty{ DIRTY_LAYOUT };
+    float m_layoutX{};  // The position the instances were laid out at.
+    float m_layoutY{};
+    std::uint64_t m_layoutTextureVersion{};  // The font's texture version the instances were laid out with.
+    std::uint64_t m_version{};
+    RetainedTextAllocation m_allocation{};
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "text_draw_list.hpp"
+#include "text_object.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/* Draws TextDrawLists & TextObjects with some graphics API, see GlTextBackend & RecordingTextBackend. */
+class TextRenderBackend
+{
+public:
+    virtual ~TextRenderBackend() = default;
+
+    virtual void begin_frame() = 0;
+    /* Draws `drawList` to a viewport of `viewportWidth` by `viewportHeight` pixels. May be called several times a frame. */
+    virtual void render(const TextDrawList& drawList, std::uint32_t viewportWidth, std::uint32_t viewportHeight) = 0;
+    /*
+     * Updates & draws retained text. Only objects whose instances changed since they were last drawn are uploaded.
+     * An object is tied to the first backend that draws it until it is destroyed.
+     */
+    virtual void render(std::span<TextObject* const> objects, std::uint32_t viewportWidth, std::uint32_t viewportHeight) = 0;
+    virtual void end_frame() = 0;
+
+    /* Frees the allocation of an object drawn by this backend, called when the object is destroyed. */
+    virtual void release(TextObject& object) = 0;
+};
+
+/* A render call as seen by a RecordingTextBackend. */
+struct TextRecording
+{
+    std::uint64_t frame{};
+    std::uint32_t viewportWidth{};
+    std::uint32_t viewportHeight{};
+    TextDrawList drawList{};
+};
+
+/*
+ * A backend without a GPU, which records what it is asked to draw. For golden tests of layout output & for layout
+ * benchmarks, which can turn recording off and only count.
+ */
+class RecordingTextBackend final : public TextRenderBackend
+{
+public:
+    explicit RecordingTextBackend(bool keepDrawLists = true);
+
+    void begin_frame() override;
+    void render(const TextDrawList& drawList, std::uint32_t viewportWidth, std::uint32_t viewportHeight) override;
+    /* Recorded as a draw list with a draw per object. */
+    void render(std::span<TextObject* const> objects, std::uint32_t viewportWidth, std::uint32_t viewportHeight) override;
+    void end_frame() override;
+    void release(TextObject& object) override;
+
+    auto get_recordings() const -> const std::vector<TextRecording>& { return m_recordings; }
+    /* The number of frames ended so far. */
+    auto get_frame_count() const -> std::uint64_t { return m_frame; }
+    /* Totals over every render call so far. */
+    auto get_draw_count() const -> std::uint64_t { return m_drawCount; }
+    auto get_instance_count() const -> std::uint64_t { return m_instanceCount; }
+    /* The number of times a text object's instances were uploaded. */
+    auto get_upload_count() const -> std::uint64_t { return m_uploadCount; }
+
+    /* Forgets the recordings & resets the counters. */
+    void clear();
+
+private:
+    bool m_keepDrawLists{};
+    std::vector<TextRecording> m_recordings{};
+    std::uint64_t m_frame{};
+    std::uint64_t m_drawCount{};
+    std::uint64_t m_instanceCount{};
+    std::uint64_t m_uploadCount{};
+    TextDrawList m_objectDrawList{};
+};
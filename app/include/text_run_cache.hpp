@@ -0,0 +1,60 @@
+#pragma once
+
+#include "text_instances.hpp"
+
+#include <cstdint>
+#include <list>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class Font;
+
+#define TEXT_RUN_CACHE_DEFAULT_BYTES (std::size_t(4) << 20)
+
+/*
+ * A least recently used cache of laid out strings, for immediate mode text that is drawn again every frame.
+ *
+ * Runs are keyed by font id, size & string and laid out with their top left corner at the origin, so one entry serves
+ * every position & color the string is drawn with. Entries laid out before the font's atlas changed are laid out again.
+ * The cache evicts the least recently used runs once the entries take more than its budget.
+ */
+class TextRunCache
+{
+public:
+    explicit TextRunCache(std::size_t maxBytes = TEXT_RUN_CACHE_DEFAULT_BYTES);
+
+    /* Returns the instances of `text` laid out at the origin. Valid until the next call, colors are left zero. */
+    auto get(Font& font, std::string_view text, float fontSize) -> std::span<const GlyphInstance>;
+
+    void clear();
+
+    auto get_hit_count() const -> std::uint64_t { return m_hits; }
+    auto get_miss_count() const -> std::uint64_t { return m_misses; }
+    /* The approximate memory used by the entries, at most the budget unless a single run exceeds it. */
+    auto get_used_bytes() const -> std::size_t { return m_usedBytes; }
+    auto get_entry_count() const -> std::size_t { return m_entries.size(); }
+
+private:
+    struct Entry
+    {
+        std::uint64_t hash{};
+        std::uint64_t fontId{};  // Font::get_id, as a font freed since may have left its address to another.
+        float fontSize{};
+        std::uint64_t textureVersion{};  // The font's texture version the run was laid out with.
+        std::string text{};
+        std::vector<GlyphInstance> instances{};
+    };
+
+    static auto GetEntryBytes(const Entry& entry) -> std::size_t;
+    void evict(std::list<Entry>::iterator entry);
+
+    std::size_t m_maxBytes{};
+    std::size_t m_usedBytes{};
+    std::list<Entry> m_entries{};  // Most recently used first.
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> m_lookup{};
+    std::uint64_t m_hits{};
+    std::uint64_t m_misses{};
+};
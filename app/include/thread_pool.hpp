@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ * A persistent pool of worker threads shared by every atlas stage, replacing msdf_atlas::Workload which spawns and
+ * joins its threads on every call.
+ *
+ * Every worker has its own task queue. Tasks submitted from a worker go to its own queue, others are spread round
+ * robin, and a worker whose queue runs dry steals from the back of the others.
+ */
+class ThreadPool
+{
+public:
+    /* Starts `threadCount` workers. Zero uses one less than the hardware threads, the caller of parallel_for makes up the last one. */
+    explicit ThreadPool(std::uint32_t threadCount = 0);
+    /* Runs every task still queued before joining the workers. */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+
+    /* The pool used by the atlas generators & FontLibrary, started on first use. */
+    static auto get_shared() -> ThreadPool&;
+
+    auto get_thread_count() const -> std::uint32_t;
+    /* Upper bound of the slot numbers passed to parallel_for bodies, for sizing per-thread scratch buffers. */
+    auto get_max_concurrency() const -> std::uint32_t;
+
+    /* Queues `func` to run on a worker. Errors are rethrown by the returned future. */
+    template <typename Func>
+    auto submit(Func&& func) -> std::future<std::invoke_result_t<std::decay_t<Func>>>;
+
+    /*
+     * Calls `func(index, slot)` for every index in [0, count) and returns once all calls have finished. The calling
+     * thread takes part. Indices are handed out in chunks of `chunkSize` (zero picks one), no two threads share a
+     * slot within one call, and `func` must not throw.
+     */
+    template <typename Func>
+    void parallel_for(std::size_t count, Func&& func, std::size_t chunkSize = 0);
+
+private:
+    using Task = std::function<void()>;
+
+    struct Queue
+    {
+        std::mutex mutex{};
+        std::deque<Task> tasks{};
+    };
+
+    void push(Task task);
+    auto pop(std::uint32_t worker, Task& outTask) -> bool;
+    void worker_main(std::uint32_t worker);
+
+    std::vector<std::unique_ptr<Queue>> m_queues{};
+    std::vector<std::thread> m_workers{};
+    std::atomic<std::uint32_t> m_nextQueue{ 0 };
+    std::atomic<std::size_t> m_pendingTasks{ 0 };
+    std::mutex m_sleepMutex{};
+    std::condition_variable m_wakeCondition{};
+    bool m_stopping{ false };
+};
+
+template <typename Func>
+auto ThreadPool::submit(Func&& func) -> std::future<std::invoke_result_t<std::decay_t<Func>>>
+{
+    using Result = std::invoke_result_t<std::decay_t<Func>>;
+
+    // std::function must be copyable, the packaged task is not.
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+    auto future = task->get_future();
+    push([task] { (*task)(); });
+    return future;
+}
+
+template <typename Func>
+void ThreadPool::parallel_for(std::size_t count, Func&& func, std::size_t chunkSize)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (chunkSize == 0)
+    {
+        // A few chunks per thread, so threads that finish early can pick up the slack.
+        chunkSize = std::max<std::size_t>(1, count / (std::size_t(get_max_concurrency()) * 4));
+    }
+
+    struct Job
+    {
+        std::atomic<std::size_t> nextIndex{ 0 };
+        std::atomic<std::size_t> remaining{ 0 };
+        std::atomic<std::uint32_t> nextSlot{ 0 };
+        std::size_t count{};
+        std::size_t chunkSize{};
+    };
+    auto job = std::make_shared<Job>();
+    job->remaining = count;
+    job->count = count;
+    job->chunkSize = chunkSize;
+
+    // Helpers that only start after the job is done find no chunk left and never touch `func`, which is gone by then.
+    auto* body = &func;
+    auto runChunks = [body](Job& job)
+    {
+        const auto slot = job.nextSlot.fetch_add(1, std::memory_order_relaxed);
+        std::size_t begin{};
+        while ((begin = job.nextIndex.fetch_add(job.chunkSize, std::memory_order_relaxed)) < job.count)
+        {
+            const auto end = std::min(begin + job.chunkSize, job.count);
+            for (auto i = begin; i < end; ++i)
+            {
+                (*body)(i, slot);
+            }
+            if (job.remaining.fetch_sub(end - begin, std::memory_order_acq_rel) == end - begin)
+            {
+                job.remaining.notify_all();
+            }
+        }
+    };
+
+    const auto chunkCount = (count + chunkSize - 1) / chunkSize;
+    const auto helperCount = std::min<std::size_t>(m_workers.size(), chunkCount - 1);
+    for (std::size_t i = 0; i < helperCount; ++i)
+    {
+        push([job, runChunks] { runChunks(*job); });
+    }
+
+    runChunks(*job);
+
+    std::size_t remaining{};
+    while ((remaining = job->remaining.load(std::memory_order_acquire)) != 0)
+    {
+        job->remaining.wait(remaining, std::memory_order_acquire);
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#define UTF8_REPLACEMENT_CHARACTER 0xFFFDu
+
+/* Returns the index of the first byte at or after `index` that is not ASCII, or the size of `text` if there is none. */
+auto find_ascii_end(std::string_view text, std::size_t index) -> std::size_t;
+
+/*
+ * Reads the codepoints of a UTF-8 string one at a time, without allocating.
+ *
+ * Decodes like msdf_atlas::utf8Decode, except that malformed or truncated sequences become one
+ * UTF8_REPLACEMENT_CHARACTER each, rather than being dropped. Runs of ASCII are found 16 bytes at a time and their bytes
+ * are returned as is, so text that is all ASCII is never decoded.
+ */
+class Utf8Reader
+{
+public:
+    explicit Utf8Reader(std::string_view text)
+        : m_text(text)
+    {
+    }
+
+    /* Outputs the next codepoint, returns false at the end of the text. */
+    auto next(std::uint32_t& codepoint) -> bool
+    {
+        if (m_index < m_asciiEnd)
+        {
+            codepoint = std::uint8_t(m_text[m_index++]);
+            return true;
+        }
+        if (m_index >= m_text.size())
+        {
+            return false;
+        }
+
+        const auto lead = std::uint8_t(m_text[m_index]);
+        if (lead < 0x80)
+        {
+            m_asciiEnd = find_ascii_end(m_text, m_index);
+            codepoint = lead;
+            ++m_index;
+            return true;
+        }
+
+        codepoint = decode();
+        return true;
+    }
+
+    /* The byte offset of the next codepoint. */
+    auto get_offset() const -> std::size_t { return m_index; }
+
+private:
+    auto decode() -> std::uint32_t
+    {
+        const auto lead = std::uint8_t(m_text[m_index++]);
+        std::uint32_t length{};
+        std::uint32_t codepoint{};
+        std::uint32_t minimum{};
+        if ((lead & 0xE0) == 0xC0)
+        {
+            length = 1;
+            codepoint = lead & 0x1F;
+            minimum = 0x80;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            length = 2;
+            codepoint = lead & 0x0F;
+            minimum = 0x800;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            length = 3;
+            codepoint = lead & 0x07;
+            minimum = 0x10000;
+        }
+        else
+        {
+            return UTF8_REPLACEMENT_CHARACTER;  // A stray continuation byte or an invalid lead byte.
+        }
+
+        for (std::uint32_t i = 0; i < length; ++i)
+        {
+            if (m_index >= m_text.size() || (std::uint8_t(m_text[m_index]) & 0xC0) != 0x80)
+            {
+                return UTF8_REPLACEMENT_CHARACTER;  // Truncated, the byte that ended it is read next.
+            }
+            codepoint = (codepoint << 6) | (std::uint8_t(m_text[m_index++]) & 0x3F);
+        }
+
+        // Overlong encodings, surrogates & values past the Unicode range.
+        if (codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+        {
+            return UTF8_REPLACEMENT_CHARACTER;
+        }
+        return codepoint;
+    }
+
+    std::string_view m_text;
+    std::size_t m_index{};
+    std::size_t m_asciiEnd{};  // Bytes before this are known to be ASCII.
+};
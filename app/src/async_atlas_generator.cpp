@@ -0,0 +1,96 @@
+#include "async_atlas_generator.hpp"
+#include "atlas_generator.hpp"
+#include "font_bundle.hpp"
+
+#include <algorithm>
+
+#define GLYPH_BATCH_SIZE 32
+
+AsyncAtlasGenerator::AsyncAtlasGenerator(std::vector<msdf_atlas::GlyphGeometry> glyphs,
+                                         const FontConfig& config,
+                                         FontData& data,
+                                         std::filesystem::path cacheFilename)
+    : m_glyphs(std::move(glyphs)),
+      m_config(config),
+      m_data(data),
+      m_cacheFilename(std::move(cacheFilename)),
+      m_glyphReady(new std::atomic<bool>[data.glyphs.size()])
+{
+    for (std::size_t i = 0; i < m_data.glyphs.size(); ++i)
+    {
+        m_glyphReady[i] = false;
+    }
+
+    m_glyphPositions.reserve(m_glyphs.size());
+    for (const auto& glyph : m_glyphs)
+    {
+        auto it = std::lower_bound(m_data.glyphs.begin(),
+                                   m_data.glyphs.end(),
+                                   glyph.getCodepoint(),
+                                   [](const AtlasGlyph& atlasGlyph, msdf_atlas::unicode_t value) { return atlasGlyph.codepoint < value; });
+        m_glyphPositions.push_back(std::size_t(it - m_data.glyphs.begin()));
+    }
+
+    m_thread = std::thread(&AsyncAtlasGenerator::run, this);
+}
+
+AsyncAtlasGenerator::~AsyncAtlasGenerator()
+{
+    m_cancelled = true;
+    m_thread.join();
+}
+
+auto AsyncAtlasGenerator::is_glyph_ready(std::size_t glyphPosition) const -> bool
+{
+    return m_finished.load(std::memory_order_acquire) || m_glyphReady[glyphPosition].load(std::memory_order_acquire);
+}
+
+auto AsyncAtlasGenerator::is_finished() const -> bool
+{
+    return m_finished.load(std::memory_order_acquire);
+}
+
+void AsyncAtlasGenerator::wait()
+{
+    m_finished.wait(false);
+}
+
+auto AsyncAtlasGenerator::get_texture_version() const -> std::uint64_t
+{
+    return m_textureVersion.load(std::memory_order_acquire);
+}
+
+auto AsyncAtlasGenerator::lock_texture() -> std::unique_lock<std::mutex>
+{
+    return std::unique_lock(m_textureMutex);
+}
+
+void AsyncAtlasGenerator::run()
+{
+    color_atlas_glyphs(m_glyphs, m_config);
+
+    for (std::size_t start = 0; start < m_glyphs.size(); start += GLYPH_BATCH_SIZE)
+    {
+        if (m_cancelled)
+        {
+            return;
+        }
+
+        const auto count = std::min<std::size_t>(GLYPH_BATCH_SIZE, m_glyphs.size() - start);
+        generate_atlas_glyphs({ m_glyphs.data() + start, count }, m_config, m_data, &m_textureMutex);
+
+        for (std::size_t i = start; i < start + count; ++i)
+        {
+            m_glyphReady[m_glyphPositions[i]].store(true, std::memory_order_release);
+        }
+        m_textureVersion.fetch_add(1, std::memory_order_release);
+    }
+
+    m_finished.store(true, std::memory_order_release);
+    m_finished.notify_all();
+
+    if (!m_cacheFilename.empty())
+    {
+        write_font_bundle(m_cacheFilename, m_data);
+    }
+}
@@ -0,0 +1,445 @@
+#include "atlas_generator.hpp"
+#include "font_kerning.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+#define DEFAULT_ANGLE_THRESHOLD 3
+#define LCG_MULTIPLIER 6364136223846793005ull
+#define LCG_INCREMENT 1442695040888963407ul
+#define GLYPH_BAND_HEIGHT 16
+#define BANDED_GLYPH_MIN_AREA (128 * 128)
+#define GLYPH_LOAD_CHUNK_SIZE std::size_t(64)
+
+/* Rough cost of generating `rows` rows of `glyph`, every texel is evaluated against every edge. */
+static auto EstimateGlyphCost(const msdf_atlas::GlyphGeometry& glyph, int rows) -> std::uint64_t
+{
+    int w, h;
+    glyph.getBoxSize(w, h);
+    return std::uint64_t(w) * std::uint64_t(rows) * std::uint64_t(std::max(1, glyph.getShape().edgeCount()));
+}
+
+/* Generates rows [firstRow, firstRow + `band.height`) of `glyph` into `band`, without the passes that need the whole glyph. */
+template <int N>
+static void GenerateGlyphBand(const msdfgen::BitmapRef<float, N>& band,
+                              const msdf_atlas::GlyphGeometry& glyph,
+                              int firstRow,
+                              const msdf_atlas::GeneratorAttributes& attributes)
+{
+    // Shift the projection down so the band's first row lands on row zero of `band`.
+    const auto scale = glyph.getBoxScale();
+    const auto translate = glyph.getBoxTranslate() - msdfgen::Vector2(0.0, firstRow / scale);
+    const msdfgen::Projection projection(msdfgen::Vector2(scale), translate);
+
+    msdfgen::MSDFGeneratorConfig config(attributes.config);
+    config.errorCorrection.mode = msdfgen::ErrorCorrectionConfig::DISABLED;
+    if constexpr (N == 3)
+    {
+        msdfgen::generateMSDF(band, glyph.getShape(), projection, glyph.getBoxRange(), config);
+    }
+    else
+    {
+        msdfgen::generateMTSDF(band, glyph.getShape(), projection, glyph.getBoxRange(), config);
+    }
+}
+
+/* The passes of msdf_atlas::msdfGenerator that follow generation, run once every band of `glyph` is done. */
+template <int N>
+static void FinishBandedGlyph(const msdfgen::BitmapRef<float, N>& bitmap,
+                              const msdf_atlas::GlyphGeometry& glyph,
+                              const msdf_atlas::GeneratorAttributes& attributes)
+{
+    msdfgen::distanceSignCorrection(bitmap, glyph.getShape(), glyph.getBoxProjection(), MSDF_ATLAS_GLYPH_FILL_RULE);
+    if (attributes.config.errorCorrection.mode != msdfgen::ErrorCorrectionConfig::DISABLED)
+    {
+        msdfgen::MSDFGeneratorConfig config(attributes.config);
+        config.errorCorrection.distanceCheckMode = msdfgen::ErrorCorrectionConfig::DO_NOT_CHECK_DISTANCE;
+        msdfgen::msdfErrorCorrection(bitmap, glyph.getShape(), glyph.getBoxProjection(), glyph.getBoxRange(), config);
+    }
+}
+
+/*
+ * Generates each glyph into a per-thread buffer and blits it into its box in `texture`.
+ *
+ * Glyphs are handed out most expensive first (longest processing time first), so a late complex glyph can't leave
+ * the other threads idle at the end. Glyphs too large to be a single unit of work, because they are huge or
+ * outweigh a thread's fair share, are split into row bands that run on separate threads. The thread finishing a
+ * glyph's last band runs its sign & error correction over the whole glyph. Every glyph still lands in its own box,
+ * so neither the order nor the banding affects the texture.
+ */
+template <int N, msdf_atlas::GeneratorFunction<float, N> GenFunc>
+static void GenerateGlyphs(std::span<const msdf_atlas::GlyphGeometry> glyphs,
+                           const msdfgen::BitmapRef<msdfgen::byte, N>& texture,
+                           std::mutex* textureMutex)
+{
+    msdf_atlas::GeneratorAttributes attributes{};
+    attributes.config.overlapSupport = true;
+    attributes.scanlinePass = true;
+
+    auto& threadPool = ThreadPool::get_shared();
+    const auto slotCount = threadPool.get_max_concurrency();
+
+    std::uint64_t totalCost = 0;
+    for (const auto& glyph : glyphs)
+    {
+        int w, h;
+        glyph.getBoxSize(w, h);
+        totalCost += glyph.isWhitespace() ? 0 : EstimateGlyphCost(glyph, h);
+    }
+
+    struct BandedGlyph
+    {
+        std::vector<float> bitmap{};
+        std::atomic<int> remainingBands{};
+    };
+    struct WorkItem
+    {
+        std::uint64_t cost{};
+        std::uint32_t glyph{};
+        std::int32_t band{};  // -1 for a whole glyph, otherwise the band & the position of its BandedGlyph.
+        std::uint32_t bandedGlyph{};
+    };
+
+    int maxBoxArea = 0;
+    int maxWholeBoxArea = 0;
+    std::vector<WorkItem> schedule{};
+    schedule.reserve(glyphs.size());
+    std::vector<std::uint32_t> bandedGlyphIndices{};
+    for (std::size_t i = 0; i < glyphs.size(); ++i)
+    {
+        const auto& glyph = glyphs[i];
+        if (glyph.isWhitespace())
+        {
+            continue;
+        }
+
+        int w, h;
+        glyph.getBoxSize(w, h);
+        maxBoxArea = std::max(maxBoxArea, w * h);
+
+        const auto cost = EstimateGlyphCost(glyph, h);
+        const bool banded = h >= 2 * GLYPH_BAND_HEIGHT && (w * h >= BANDED_GLYPH_MIN_AREA || cost * slotCount > totalCost);
+        if (!banded)
+        {
+            maxWholeBoxArea = std::max(maxWholeBoxArea, w * h);
+            schedule.push_back({ cost, std::uint32_t(i), -1, 0 });
+            continue;
+        }
+
+        const auto bandCount = (h + GLYPH_BAND_HEIGHT - 1) / GLYPH_BAND_HEIGHT;
+        for (int band = 0; band < bandCount; ++band)
+        {
+            const auto rows = std::min(GLYPH_BAND_HEIGHT, h - band * GLYPH_BAND_HEIGHT);
+            schedule.push_back({ EstimateGlyphCost(glyph, rows), std::uint32_t(i), band, std::uint32_t(bandedGlyphIndices.size()) });
+        }
+        bandedGlyphIndices.push_back(std::uint32_t(i));
+    }
+    // Ties broken by position, so the schedule is deterministic.
+    std::sort(schedule.begin(),
+              schedule.end(),
+              [](const WorkItem& a, const WorkItem& b)
+              {
+                  return a.cost > b.cost || (a.cost == b.cost && (a.glyph < b.glyph || (a.glyph == b.glyph && a.band < b.band)));
+              });
+
+    std::vector<BandedGlyph> bandedGlyphs(bandedGlyphIndices.size());
+    for (std::size_t i = 0; i < bandedGlyphs.size(); ++i)
+    {
+        int w, h;
+        glyphs[bandedGlyphIndices[i]].getBoxSize(w, h);
+        bandedGlyphs[i].bitmap.resize(std::size_t(N) * w * h);
+        bandedGlyphs[i].remainingBands = (h + GLYPH_BAND_HEIGHT - 1) / GLYPH_BAND_HEIGHT;
+    }
+
+    std::vector<float> glyphBuffer(std::size_t(slotCount) * N * maxWholeBoxArea);
+    std::vector<msdfgen::byte> errorCorrectionBuffer(std::size_t(slotCount) * maxBoxArea);
+    std::vector<msdf_atlas::GeneratorAttributes> slotAttributes(slotCount, attributes);
+    for (std::uint32_t i = 0; i < slotCount; ++i)
+    {
+        slotAttributes[i].config.errorCorrection.buffer = errorCorrectionBuffer.data() + std::size_t(i) * maxBoxArea;
+    }
+
+    auto blitGlyph = [&](const msdfgen::BitmapConstRef<float, N>& glyphBitmap, int l, int b, int w, int h)
+    {
+        std::unique_lock<std::mutex> lock{};
+        if (textureMutex)
+        {
+            lock = std::unique_lock(*textureMutex);
+        }
+        msdf_atlas::blit(texture, glyphBitmap, l, b, 0, 0, w, h);
+    };
+
+    // One item at a time, chunks would clump the expensive items at the front together.
+    threadPool.parallel_for(
+        schedule.size(),
+        [&](std::size_t i, std::uint32_t slot)
+        {
+            const auto& item = schedule[i];
+            const auto& glyph = glyphs[item.glyph];
+
+            int l, b, w, h;
+            glyph.getBoxRect(l, b, w, h);
+            if (item.band < 0)
+            {
+                msdfgen::BitmapRef<float, N> glyphBitmap(glyphBuffer.data() + std::size_t(slot) * N * maxWholeBoxArea, w, h);
+                GenFunc(glyphBitmap, glyph, slotAttributes[slot]);
+                blitGlyph(glyphBitmap, l, b, w, h);
+                return;
+            }
+
+            auto& bandedGlyph = bandedGlyphs[item.bandedGlyph];
+            const auto firstRow = item.band * GLYPH_BAND_HEIGHT;
+            const auto rows = std::min(GLYPH_BAND_HEIGHT, h - firstRow);
+            msdfgen::BitmapRef<float, N> band(bandedGlyph.bitmap.data() + std::size_t(N) * w * firstRow, w, rows);
+            GenerateGlyphBand<N>(band, glyph, firstRow, slotAttributes[slot]);
+
+            // acq_rel makes the other bands' rows visible to whichever thread finishes the glyph.
+            if (bandedGlyph.remainingBands.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                msdfgen::BitmapRef<float, N> glyphBitmap(bandedGlyph.bitmap.data(), w, h);
+                FinishBandedGlyph<N>(glyphBitmap, glyph, slotAttributes[slot]);
+                blitGlyph(glyphBitmap, l, b, w, h);
+            }
+        },
+        1);
+}
+
+/*
+ * Loads & preprocesses the glyphs of `codepoints` that exist in the font, in order. Chunks of codepoints are loaded
+ * in parallel, every thread through a FreeType instance & face of its own, then concatenated in codepoint order so
+ * the result matches a serial load. Small charsets are loaded serially through `font`.
+ */
+static auto LoadGlyphs(std::span<const std::uint8_t> fontData,
+                       msdfgen::FontHandle* font,
+                       double geometryScale,
+                       std::span<const msdf_atlas::unicode_t> codepoints) -> std::vector<msdf_atlas::GlyphGeometry>
+{
+    auto loadChunk =
+        [&](msdfgen::FontHandle* chunkFont, std::size_t begin, std::size_t end, std::vector<msdf_atlas::GlyphGeometry>& outGlyphs)
+    {
+        for (auto i = begin; i < end; ++i)
+        {
+            msdf_atlas::GlyphGeometry glyph{};
+            if (glyph.load(chunkFont, geometryScale, codepoints[i]))
+            {
+                outGlyphs.push_back(std::move(glyph));
+            }
+        }
+    };
+
+    std::vector<msdf_atlas::GlyphGeometry> glyphs{};
+    const auto chunkCount = (codepoints.size() + GLYPH_LOAD_CHUNK_SIZE - 1) / GLYPH_LOAD_CHUNK_SIZE;
+    if (chunkCount <= 1)
+    {
+        loadChunk(font, 0, codepoints.size(), glyphs);
+        return glyphs;
+    }
+
+    // Faces are created & destroyed with their own FreeType instance, so no library is touched by two threads.
+    struct SlotFont
+    {
+        std::unique_ptr<msdfgen::FreetypeHandle, decltype(&msdfgen::deinitializeFreetype)> freetype{ nullptr,
+                                                                                                     &msdfgen::deinitializeFreetype };
+        std::unique_ptr<msdfgen::FontHandle, decltype(&msdfgen::destroyFont)> font{ nullptr, &msdfgen::destroyFont };
+    };
+    auto& threadPool = ThreadPool::get_shared();
+    std::vector<SlotFont> slotFonts(threadPool.get_max_concurrency());
+    std::vector<std::vector<msdf_atlas::GlyphGeometry>> chunkGlyphs(chunkCount);
+    std::atomic<bool> loadFailed{ false };  // parallel_for bodies must not throw, a failed load is reported afterwards.
+    threadPool.parallel_for(
+        chunkCount,
+        [&](std::size_t chunk, std::uint32_t slot)
+        {
+            auto& slotFont = slotFonts[slot];
+            if (!slotFont.font)
+            {
+                slotFont.freetype.reset(msdfgen::initializeFreetype());
+                if (slotFont.freetype)
+                {
+                    slotFont.font.reset(msdfgen::loadFontData(slotFont.freetype.get(), fontData.data(), std::int32_t(fontData.size())));
+                }
+                if (!slotFont.font)
+                {
+                    loadFailed.store(true, std::memory_order_relaxed);
+                    return;
+                }
+            }
+
+            const auto begin = chunk * GLYPH_LOAD_CHUNK_SIZE;
+            loadChunk(slotFont.font.get(), begin, std::min(begin + GLYPH_LOAD_CHUNK_SIZE, codepoints.size()), chunkGlyphs[chunk]);
+        },
+        1);
+    if (loadFailed.load(std::memory_order_relaxed))
+    {
+        throw std::runtime_error("Failed to load font from memory.");
+    }
+
+    std::size_t glyphCount = 0;
+    for (const auto& chunk : chunkGlyphs)
+    {
+        glyphCount += chunk.size();
+    }
+    glyphs.reserve(glyphCount);
+    for (auto& chunk : chunkGlyphs)
+    {
+        std::move(chunk.begin(), chunk.end(), std::back_inserter(glyphs));
+    }
+    return glyphs;
+}
+
+auto get_charset_codepoints(const FontConfig& config) -> std::vector<msdf_atlas::unicode_t>
+{
+    std::vector<msdf_atlas::unicode_t> codepoints{};
+    for (const auto& range : config.charsetRanges)
+    {
+        for (auto character = range.begin; character <= range.end; ++character)
+        {
+            codepoints.push_back(character);
+        }
+    }
+    return codepoints;
+}
+
+void load_atlas_glyphs(std::span<const std::uint8_t> fontData,
+                       const FontConfig& config,
+                       msdfgen::FreetypeHandle* ft,
+                       std::vector<msdf_atlas::GlyphGeometry>& outGlyphs,
+                       FontData& outData)
+{
+    // FreeType reads the face straight from `fontData`, which must outlive `font`.
+    msdfgen::FontHandle* font = msdfgen::loadFontData(ft, fontData.data(), std::int32_t(fontData.size()));
+    if (!font)
+    {
+        throw std::runtime_error("Failed to load font from memory.");
+    }
+
+    // Sorted & deduplicated, the order FontGeometry::loadCharset would load in.
+    msdf_atlas::Charset charset{};
+    for (auto codepoint : get_charset_codepoints(config))
+    {
+        charset.add(codepoint);
+    }
+    const std::vector<msdf_atlas::unicode_t> codepoints(charset.begin(), charset.end());
+
+    auto& glyphs = outGlyphs;
+    double fontScale = 1.0;
+    msdf_atlas::FontGeometry geometry(&glyphs);
+    geometry.loadMetrics(font, fontScale);
+    for (auto& glyph : LoadGlyphs(fontData, font, geometry.getGeometryScale(), codepoints))
+    {
+        geometry.addGlyph(std::move(glyph));
+    }
+
+    msdfgen::destroyFont(font);
+
+    msdf_atlas::TightAtlasPacker atlasPacker{};
+    // atlasPacker.setDimensionsConstraint();
+    atlasPacker.setPixelRange(config.pixelRange);
+    atlasPacker.setMiterLimit(config.miterLimit);
+    atlasPacker.setPadding(config.padding);
+    atlasPacker.setScale(config.emSize);
+    int remaining = atlasPacker.pack(glyphs.data(), std::int32_t(glyphs.size()));
+    assert(remaining == 0);
+
+    std::int32_t width{};
+    std::int32_t height{};
+    atlasPacker.getDimensions(width, height);
+
+    outData.emSize = config.emSize;
+    outData.pixelRange = config.pixelRange;
+    outData.textureWidth = width;
+    outData.textureHeight = height;
+    switch (config.atlasType)
+    {
+        case AtlasType::MSDF: outData.textureChannels = 3; break;
+        case AtlasType::MTSDF: outData.textureChannels = 4; break;
+    }
+    outData.ownedTextureData.assign(std::size_t(width) * height * outData.textureChannels, 0);
+
+    outData.metrics = geometry.getMetrics();
+    outData.ownedGlyphs.reserve(glyphs.size());
+    for (const auto& glyph : glyphs)
+    {
+        auto& atlasGlyph = outData.ownedGlyphs.emplace_back();
+        atlasGlyph.codepoint = glyph.getCodepoint();
+        atlasGlyph.index = glyph.getIndex();
+        atlasGlyph.advance = glyph.getAdvance();
+        glyph.getQuadPlaneBounds(atlasGlyph.planeLeft, atlasGlyph.planeBottom, atlasGlyph.planeRight, atlasGlyph.planeTop);
+        glyph.getQuadAtlasBounds(atlasGlyph.atlasLeft, atlasGlyph.atlasBottom, atlasGlyph.atlasRight, atlasGlyph.atlasTop);
+    }
+    std::sort(outData.ownedGlyphs.begin(),
+              outData.ownedGlyphs.end(),
+              [](const AtlasGlyph& a, const AtlasGlyph& b) { return a.codepoint < b.codepoint; });
+
+    std::vector<std::int32_t> glyphIndices{};
+    glyphIndices.reserve(glyphs.size());
+    for (const auto& glyph : glyphs)
+    {
+        glyphIndices.push_back(glyph.getIndex());
+    }
+    std::sort(glyphIndices.begin(), glyphIndices.end());
+    outData.ownedKerning = load_font_kerning(fontData, glyphIndices, fontScale);
+
+    outData.glyphs = outData.ownedGlyphs;
+    outData.kerning = outData.ownedKerning;
+    outData.textureData = outData.ownedTextureData;
+}
+
+void color_atlas_glyphs(std::span<msdf_atlas::GlyphGeometry> glyphs, const FontConfig& config)
+{
+    // if MSDF || MTSDF
+    std::uint64_t coloringSeed = config.coloringSeed;
+    if (config.expensiveColoring)
+    {
+        ThreadPool::get_shared().parallel_for(glyphs.size(),
+                                              [&glyphs, &coloringSeed](std::size_t i, std::uint32_t slot)
+                                              {
+                                                  (void)(slot);
+                                                  unsigned long long glyphSeed =
+                                                      (LCG_MULTIPLIER * (coloringSeed ^ i) + LCG_INCREMENT) * !!coloringSeed;
+                                                  glyphs[i].edgeColoring(msdfgen::edgeColoringInkTrap, DEFAULT_ANGLE_THRESHOLD, glyphSeed);
+                                              });
+    }
+    else
+    {
+        unsigned long long glyphSeed = coloringSeed;
+        for (msdf_atlas::GlyphGeometry& glyph : glyphs)
+        {
+            glyphSeed *= LCG_MULTIPLIER;
+            glyph.edgeColoring(msdfgen::edgeColoringByDistance, DEFAULT_ANGLE_THRESHOLD, glyphSeed);
+        }
+    }
+}
+
+void generate_atlas_glyphs(std::span<const msdf_atlas::GlyphGeometry> glyphs,
+                           const FontConfig& config,
+                           std::uint8_t* texels,
+                           std::uint32_t width,
+                           std::uint32_t height,
+                           std::mutex* textureMutex)
+{
+    switch (config.atlasType)
+    {
+        case AtlasType::MSDF:
+            GenerateGlyphs<3, msdf_atlas::msdfGenerator>(
+                glyphs, msdfgen::BitmapRef<msdfgen::byte, 3>(texels, std::int32_t(width), std::int32_t(height)), textureMutex);
+            break;
+        case AtlasType::MTSDF:
+            GenerateGlyphs<4, msdf_atlas::mtsdfGenerator>(
+                glyphs, msdfgen::BitmapRef<msdfgen::byte, 4>(texels, std::int32_t(width), std::int32_t(height)), textureMutex);
+            break;
+    }
+}
+
+void generate_atlas_glyphs(std::span<const msdf_atlas::GlyphGeometry> glyphs,
+                           const FontConfig& config,
+                           FontData& data,
+                           std::mutex* textureMutex)
+{
+    generate_atlas_glyphs(glyphs, config, data.ownedTextureData.data(), data.textureWidth, data.textureHeight, textureMutex);
+}
@@ -0,0 +1,193 @@
+#include "dynamic_glyph_atlas.hpp"
+#include "font_kerning.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#define DEFAULT_ANGLE_THRESHOLD 3
+#define LCG_MULTIPLIER 6364136223846793005ull
+#define LCG_INCREMENT 1442695040888963407ul
+
+/* Points the texture of `data` at the atlas bitmap. The bitmap moves whenever the atlas is resized. */
+template <int N>
+static void SetTexture(const msdf_atlas::DynamicAtlas<PooledAtlasGenerator<N>>& atlas, FontData& data)
+{
+    auto bitmap = (msdfgen::BitmapConstRef<std::uint8_t, N>)atlas.atlasGenerator().atlasStorage();
+    data.textureWidth = std::uint32_t(bitmap.width);
+    data.textureHeight = std::uint32_t(bitmap.height);
+    data.textureChannels = N;
+    data.textureData = { bitmap.pixels, std::size_t(bitmap.width) * bitmap.height * N };
+}
+
+DynamicGlyphAtlas::DynamicGlyphAtlas(MappedFile fontFile, const FontConfig& config)
+    : m_config(config),
+      m_coloringSeed(config.coloringSeed),
+      m_fontFile(std::move(fontFile)),
+      m_freetype(nullptr, &msdfgen::deinitializeFreetype),
+      m_font(nullptr, &msdfgen::destroyFont)
+{
+    m_fontData = m_fontFile.bytes();
+    initialise();
+}
+
+DynamicGlyphAtlas::DynamicGlyphAtlas(std::span<const std::uint8_t> fontData, const FontConfig& config)
+    : m_config(config),
+      m_coloringSeed(config.coloringSeed),
+      m_fontBytes(fontData.begin(), fontData.end()),
+      m_freetype(nullptr, &msdfgen::deinitializeFreetype),
+      m_font(nullptr, &msdfgen::destroyFont)
+{
+    m_fontData = m_fontBytes;
+    initialise();
+}
+
+DynamicGlyphAtlas::~DynamicGlyphAtlas() = default;
+
+void DynamicGlyphAtlas::initialise()
+{
+    m_freetype.reset(msdfgen::initializeFreetype());
+    if (!m_freetype)
+    {
+        throw std::runtime_error("Failed to initialise FreeType.");
+    }
+
+    m_font.reset(msdfgen::loadFontData(m_freetype.get(), m_fontData.data(), std::int32_t(m_fontData.size())));
+    if (!m_font)
+    {
+        throw std::runtime_error("Failed to load font from memory.");
+    }
+
+    double fontScale = 1.0;
+    m_geometry.loadMetrics(m_font.get(), fontScale);
+
+    auto createAtlas = [this](auto& atlas)
+    {
+        using Atlas = std::decay_t<decltype(atlas)>;
+        std::decay_t<decltype(atlas.atlasGenerator())> generator{};
+        generator.set_config(m_config);
+        atlas = Atlas(std::move(generator));
+    };
+    switch (m_config.atlasType)
+    {
+        case AtlasType::MSDF: createAtlas(m_atlas.emplace<0>()); break;
+        case AtlasType::MTSDF: createAtlas(m_atlas.emplace<1>()); break;
+    }
+}
+
+auto DynamicGlyphAtlas::add_glyphs(std::span<const msdf_atlas::unicode_t> codepoints, FontData& data) -> bool
+{
+    const auto firstNewGlyph = m_glyphs.size();
+    std::set<msdf_atlas::unicode_t> batchCodepoints{};
+    for (auto codepoint : codepoints)
+    {
+        auto it = std::lower_bound(data.glyphs.begin(),
+                                   data.glyphs.end(),
+                                   codepoint,
+                                   [](const AtlasGlyph& glyph, msdf_atlas::unicode_t value) { return glyph.codepoint < value; });
+        const bool loaded = it != data.glyphs.end() && it->codepoint == codepoint;
+        if (loaded || is_missing(codepoint) || !batchCodepoints.insert(codepoint).second)
+        {
+            continue;
+        }
+
+        msdf_atlas::GlyphGeometry glyph{};
+        if (!glyph.load(m_font.get(), m_geometry.getGeometryScale(), codepoint))
+        {
+            m_missingCodepoints.insert(codepoint);
+            continue;
+        }
+
+        // if MSDF || MTSDF
+        const auto glyphNumber = m_glyphs.size();
+        if (m_config.expensiveColoring)
+        {
+            unsigned long long glyphSeed =
+                (LCG_MULTIPLIER * (m_config.coloringSeed ^ glyphNumber) + LCG_INCREMENT) * !!m_config.coloringSeed;
+            glyph.edgeColoring(msdfgen::edgeColoringInkTrap, DEFAULT_ANGLE_THRESHOLD, glyphSeed);
+        }
+        else
+        {
+            m_coloringSeed *= LCG_MULTIPLIER;
+            glyph.edgeColoring(msdfgen::edgeColoringByDistance, DEFAULT_ANGLE_THRESHOLD, m_coloringSeed);
+        }
+
+        // Same box as msdf_atlas::TightAtlasPacker would compute for a fixed scale.
+        glyph.wrapBox(m_config.emSize, m_config.pixelRange / m_config.emSize, m_config.miterLimit);
+        m_glyphs.push_back(std::move(glyph));
+    }
+
+    const auto newGlyphCount = m_glyphs.size() - firstNewGlyph;
+    if (newGlyphCount == 0)
+    {
+        return false;
+    }
+
+    auto* newGlyphs = m_glyphs.data() + firstNewGlyph;
+    std::visit(
+        [&](auto& atlas)
+        {
+            using Atlas = std::decay_t<decltype(atlas)>;
+            auto changeFlags = atlas.add(newGlyphs, std::int32_t(newGlyphCount), true);
+            SetTexture(atlas, data);
+            if (!(changeFlags & Atlas::REARRANGED))
+            {
+                return;
+            }
+
+            // Glyphs that were already in the atlas may have moved, the generator knows where they are now.
+            const auto& layout = atlas.atlasGenerator().getLayout();
+            for (std::size_t i = 0; i < firstNewGlyph; ++i)
+            {
+                if (!m_glyphs[i].isWhitespace())
+                {
+                    m_glyphs[i].setBoxRect(layout[i].rect);
+                }
+            }
+        },
+        m_atlas);
+
+    update_font_data(data);
+    return true;
+}
+
+auto DynamicGlyphAtlas::is_missing(msdf_atlas::unicode_t codepoint) const -> bool
+{
+    return m_missingCodepoints.contains(codepoint);
+}
+
+void DynamicGlyphAtlas::update_font_data(FontData& data)
+{
+    // Rebuilt from scratch, glyphs that were already in the atlas may have moved.
+    data.metrics = m_geometry.getMetrics();
+    data.emSize = m_config.emSize;
+    data.pixelRange = m_config.pixelRange;
+    data.ownedGlyphs.clear();
+    data.ownedGlyphs.reserve(m_glyphs.size());
+    for (const auto& glyph : m_glyphs)
+    {
+        auto& atlasGlyph = data.ownedGlyphs.emplace_back();
+        atlasGlyph.codepoint = glyph.getCodepoint();
+        atlasGlyph.index = glyph.getIndex();
+        atlasGlyph.advance = glyph.getAdvance();
+        glyph.getQuadPlaneBounds(atlasGlyph.planeLeft, atlasGlyph.planeBottom, atlasGlyph.planeRight, atlasGlyph.planeTop);
+        glyph.getQuadAtlasBounds(atlasGlyph.atlasLeft, atlasGlyph.atlasBottom, atlasGlyph.atlasRight, atlasGlyph.atlasTop);
+    }
+    std::sort(data.ownedGlyphs.begin(),
+              data.ownedGlyphs.end(),
+              [](const AtlasGlyph& a, const AtlasGlyph& b) { return a.codepoint < b.codepoint; });
+
+    // Reading the font's tables again is cheaper than querying every new pair, and picks up GPOS kerning as well.
+    std::vector<std::int32_t> glyphIndices{};
+    glyphIndices.reserve(m_glyphs.size());
+    for (const auto& glyph : m_glyphs)
+    {
+        glyphIndices.push_back(glyph.getIndex());
+    }
+    std::sort(glyphIndices.begin(), glyphIndices.end());
+    glyphIndices.erase(std::unique(glyphIndices.begin(), glyphIndices.end()), glyphIndices.end());
+    data.ownedKerning = load_font_kerning(m_fontData, glyphIndices, 1.0);
+
+    data.glyphs = data.ownedGlyphs;
+    data.kerning = data.ownedKerning;
+    ++data.textureVersion;
+}
@@ -0,0 +1,54 @@
+#include "fenwick_tree.hpp"
+
+#include <bit>
+
+static auto LowestBit(std::size_t index) -> std::size_t
+{
+    return index & (~index + 1);
+}
+
+void FenwickTree::push_back(double value)
+{
+    // The new node covers the values of the nodes below it down to the start of its range.
+    const auto index = m_nodes.size();
+    const auto rangeBegin = index - LowestBit(index);
+    auto sum = value;
+    for (auto node = index - 1; node > rangeBegin; node -= LowestBit(node))
+    {
+        sum += m_nodes[node];
+    }
+    m_nodes.push_back(sum);
+}
+
+void FenwickTree::add(std::size_t index, double delta)
+{
+    for (auto node = index + 1; node < m_nodes.size(); node += LowestBit(node))
+    {
+        m_nodes[node] += delta;
+    }
+}
+
+auto FenwickTree::prefix_sum(std::size_t count) const -> double
+{
+    double sum = 0.0;
+    for (auto node = count < size() ? count : size(); node > 0; node -= LowestBit(node))
+    {
+        sum += m_nodes[node];
+    }
+    return sum;
+}
+
+auto FenwickTree::find(double target) const -> std::size_t
+{
+    // Descends from the largest range, taking every one that still fits.
+    std::size_t count = 0;
+    for (auto step = std::bit_floor(size()); step > 0; step >>= 1)
+    {
+        if (count + step <= size() && m_nodes[count + step] <= target)
+        {
+            count += step;
+            target -= m_nodes[count];
+        }
+    }
+    return count;
+}
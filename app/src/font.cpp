@@ -1,141 +1,157 @@
 #include "font.hpp"
+#include "font_bundle.hpp"
+#include "dynamic_glyph_atlas.hpp"
+#include "atlas_generator.hpp"
+#include "async_atlas_generator.hpp"
+#include "utf8_reader.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <utility>
 
-#define DEFAULT_ANGLE_THRESHOLD 3
-#define LCG_MULTIPLIER 6364136223846793005ull
-#define LCG_INCREMENT 1442695040888963407ul
-#define THREAD_COUNT 8
-
-template <typename T, typename S, int N, msdf_atlas::GeneratorFunction<S, N> GenFunc>
-static void CreateAndCacheAtlas(float fontSize,
-                                const std::vector<msdf_atlas::GlyphGeometry>& glyphs,
-                                const msdf_atlas::FontGeometry& fontGeometry,
-                                std::uint32_t width,
-                                std::uint32_t height,
-                                std::vector<T>& outData)
+/*
+ * Maps a cached atlas for `fontData` if there is one, otherwise generates the atlas and caches it.
+ * With `config.asyncGeneration` the atlas is generated (and cached) in the background by the returned generator.
+ */
+static auto LoadFontData(std::span<const std::uint8_t> fontData,
+                         const FontConfig& config,
+                         FontData& outData,
+                         msdfgen::FreetypeHandle* ft) -> std::unique_ptr<AsyncAtlasGenerator>
 {
-    msdf_atlas::GeneratorAttributes attributes{};
-    attributes.config.overlapSupport = true;
-    attributes.scanlinePass = true;
+    std::filesystem::path cacheFilename{};
+    std::uint64_t cacheKey{};
+    if (!config.cacheDirectory.empty())
+    {
+        cacheKey = compute_atlas_cache_key(fontData, config);
+        cacheFilename = get_atlas_cache_filename(config.cacheDirectory, cacheKey);
+        if (map_font_bundle(cacheFilename, cacheKey, outData))
+        {
+            return nullptr;
+        }
+    }
+
+    std::vector<msdf_atlas::GlyphGeometry> glyphs{};
+    if (ft)
+    {
+        load_atlas_glyphs(fontData, config, ft, glyphs, outData);
+    }
+    else
+    {
+        std::unique_ptr<msdfgen::FreetypeHandle, decltype(&msdfgen::deinitializeFreetype)> ownFt(msdfgen::initializeFreetype(),
+                                                                                                  &msdfgen::deinitializeFreetype);
+        assert(ownFt);
+        load_atlas_glyphs(fontData, config, ownFt.get(), glyphs, outData);
+    }
+    outData.key = cacheKey;
 
-    msdf_atlas::ImmediateAtlasGenerator<S, N, GenFunc, msdf_atlas::BitmapAtlasStorage<T, N>> generator(width, height);
-    generator.setAttributes(attributes);
-    generator.setThreadCount(8);
-    generator.generate(glyphs.data(), std::uint32_t(glyphs.size()));
+    if (config.asyncGeneration)
+    {
+        return std::make_unique<AsyncAtlasGenerator>(std::move(glyphs), config, outData, cacheFilename);
+    }
 
-    auto bitmap = (msdfgen::BitmapConstRef<T, N>)generator.atlasStorage();
-    msdfgen::savePng(bitmap, "cached_atlas.png");
+    color_atlas_glyphs(glyphs, config);
+    generate_atlas_glyphs(glyphs, config, outData);
 
-    outData.resize(width * height * N);
-    std::memcpy(outData.data(), bitmap.pixels, outData.size());
+    if (!cacheFilename.empty())
+    {
+        write_font_bundle(cacheFilename, outData);
+    }
+    return nullptr;
 }
 
-Font::Font(const std::filesystem::path& fontFilename) : m_data(new FontData)
+Font::Font(const std::filesystem::path& fontFilename, const FontConfig& config) : m_data(new FontData)
 {
-    msdfgen::FreetypeHandle* ft = msdfgen::initializeFreetype();
-    assert(ft);
-
-    const auto fontFilenameStr = fontFilename.string();
-    // #TODO: msdfgen::loadFontData - loads font from memory buffer
-    msdfgen::FontHandle* font = msdfgen::loadFont(ft, fontFilenameStr.c_str());
-    if (!font)
+    // Map rather than read the font file, the bytes are only needed until the atlas is generated.
+    MappedFile fontFile{};
+    if (!fontFile.open(fontFilename))
     {
-        throw std::runtime_error("Failed to load font: " + fontFilenameStr);
+        throw std::runtime_error("Failed to load font: " + fontFilename.string());
     }
 
-    struct CharsetRange
+    if (config.glyphLoading == GlyphLoading::OnDemand)
     {
-        std::uint32_t begin{};
-        std::uint32_t end{};
-    };
+        m_dynamicAtlas = std::make_unique<DynamicGlyphAtlas>(std::move(fontFile), config);
+        request_glyphs(get_charset_codepoints(config));
+        return;
+    }
 
-    // Taken from ImGui - imgui_draw.cpp (GetGlyphRanges)
-    static const std::vector<CharsetRange> charsetRanges{
-        { 0x0020, 0x00FF },  // Basic Latin + Latin Supplement
-    };
+    m_asyncAtlas = LoadFontData(fontFile.bytes(), config, *m_data, nullptr);
+    m_glyphTable.build(*m_data);
+}
 
-    msdf_atlas::Charset charset{};
-    for (const auto& range : charsetRanges)
+Font::Font(std::span<const std::uint8_t> fontData, const FontConfig& config) : Font(fontData, config, nullptr) {}
+
+Font::Font(std::span<const std::uint8_t> fontData, const FontConfig& config, msdfgen::FreetypeHandle* freetype) : m_data(new FontData)
+{
+    if (fontData.empty())
     {
-        for (auto character = range.begin; character <= range.end; ++character)
-        {
-            charset.add(character);
-        }
+        throw std::runtime_error("Failed to load font from memory: buffer is empty.");
     }
 
-    double fontScale = 1.0;
-    m_data->geometry = msdf_atlas::FontGeometry(&m_data->glyphs);
-    auto glyphsLoaded = m_data->geometry.loadCharset(font, fontScale, charset);
-    (void)(glyphsLoaded);  // `charset.size() - glyphsLoaded` glyphs were loaded
-
-    double emSize = 32.0;
-    double pixelRange = 2;  // 2.5 + 1.0 / 0.1;//8.0; // Shader should use this value
-
-    msdf_atlas::TightAtlasPacker atlasPacker{};
-    // atlasPacker.setDimensionsConstraint();
-    atlasPacker.setPixelRange(pixelRange);
-    atlasPacker.setMiterLimit(1.0);
-    atlasPacker.setPadding(1);
-    atlasPacker.setScale(emSize);
-    int remaining = atlasPacker.pack(m_data->glyphs.data(), std::int32_t(m_data->glyphs.size()));
-    assert(remaining == 0);
-
-    std::int32_t width{};
-    std::int32_t height{};
-    atlasPacker.getDimensions(width, height);
-    emSize = atlasPacker.getScale();
-
-    // if MSDF || MTSDF
-    std::uint64_t coloringSeed = 0;
-    bool expensiveColoring = true;
-    if (expensiveColoring)
-    {
-        msdf_atlas::Workload(
-            [&glyphs = m_data->glyphs, &coloringSeed](int i, int threadNo) -> bool
-            {
-                unsigned long long glyphSeed = (LCG_MULTIPLIER * (coloringSeed ^ i) + LCG_INCREMENT) * !!coloringSeed;
-                glyphs[i].edgeColoring(msdfgen::edgeColoringInkTrap, DEFAULT_ANGLE_THRESHOLD, glyphSeed);
-                return true;
-            },
-            m_data->glyphs.size())
-            .finish(THREAD_COUNT);
-    }
-    else
+    if (config.glyphLoading == GlyphLoading::OnDemand)
     {
-        unsigned long long glyphSeed = coloringSeed;
-        for (msdf_atlas::GlyphGeometry& glyph : m_data->glyphs)
-        {
-            glyphSeed *= LCG_MULTIPLIER;
-            glyph.edgeColoring(msdfgen::edgeColoringByDistance, DEFAULT_ANGLE_THRESHOLD, glyphSeed);
-        }
+        // Glyphs are generated long after `freetype` has been handed back, so the atlas keeps its own instance.
+        m_dynamicAtlas = std::make_unique<DynamicGlyphAtlas>(fontData, config);
+        request_glyphs(get_charset_codepoints(config));
+        return;
     }
 
-    m_data->textureWidth = width;
-    m_data->textureHeight = height;
-    CreateAndCacheAtlas<std::uint8_t, float, 3, msdf_atlas::msdfGenerator>(
-        float(emSize), m_data->glyphs, m_data->geometry, width, height, m_data->textureData);
+    m_asyncAtlas = LoadFontData(fontData, config, *m_data, freetype);
+    m_glyphTable.build(*m_data);
+}
+
+Font::Font(const MappedFile& fontFile, const FontConfig& config) : Font(fontFile.bytes(), config) {}
+
+Font::Font(std::unique_ptr<FontData> data) : m_data(std::move(data))
+{
+    m_glyphTable.build(*m_data);
+}
+
+Font::~Font() = default;
+
+auto Font::allocate_id() -> std::uint64_t
+{
+    static std::atomic<std::uint64_t> nextId{ 1 };
+    return nextId.fetch_add(1, std::memory_order_relaxed);
+}
+
+Font::Font(Font&&) noexcept = default;
 
-#if 0
-    msdfgen::Shape shape;
-    if (msdfgen::loadGlyph(shape, font, 'A'))
+auto Font::operator=(Font&& other) noexcept -> Font&
+{
+    if (this != &other)
     {
-        shape.normalize();
-        //                      max. angle
-        edgeColoringSimple(shape, 3.0);
-        //           image width, height
-        msdfgen::Bitmap<float, 3> msdf(32, 32);
-        //                     range, scale, translation
-        msdfgen::generateMSDF(msdf, shape, 4.0, 1.0, msdfgen::Vector2(4.0, 4.0));
-        msdfgen::savePng(msdf, "output.png");
+        // A background generator writes into `m_data` until it is joined, so it has to stop before the data is freed.
+        m_asyncAtlas.reset();
+        m_id = other.m_id;
+        m_data = std::move(other.m_data);
+        m_glyphTable = std::move(other.m_glyphTable);
+        m_dynamicAtlas = std::move(other.m_dynamicAtlas);
+        m_asyncAtlas = std::move(other.m_asyncAtlas);
+        m_textureId = std::exchange(other.m_textureId, nullptr);
     }
-#endif
+    return *this;
+}
 
-    msdfgen::destroyFont(font);
-    msdfgen::deinitializeFreetype(ft);
+auto Font::from_bundle(const std::filesystem::path& bundleFilename) -> Font
+{
+    auto data = std::make_unique<FontData>();
+    if (!map_font_bundle(bundleFilename, 0, *data))
+    {
+        throw std::runtime_error("Failed to load font bundle: " + bundleFilename.string());
+    }
+    return Font(std::move(data));
 }
 
-Font::~Font() = default;
+auto Font::save_bundle(const std::filesystem::path& bundleFilename) const -> bool
+{
+    if (m_asyncAtlas)
+    {
+        m_asyncAtlas->wait();
+    }
+    return write_font_bundle(bundleFilename, *m_data);
+}
 
 auto Font::get_texture_width() const -> std::uint32_t
 {
@@ -147,17 +163,198 @@ auto Font::get_texture_height() const -> std::uint32_t
     return m_data->textureHeight;
 }
 
+auto Font::get_texture_channels() const -> std::uint32_t
+{
+    return m_data->textureChannels;
+}
+
 auto Font::get_texture_data() const -> const void*
 {
     return m_data->textureData.data();
 }
 
+auto Font::get_texture_version() const -> std::uint64_t
+{
+    if (m_asyncAtlas)
+    {
+        return m_asyncAtlas->get_texture_version();
+    }
+    return m_data->textureVersion;
+}
+
+auto Font::lock_texture() -> std::unique_lock<std::mutex>
+{
+    if (m_asyncAtlas)
+    {
+        return m_asyncAtlas->lock_texture();
+    }
+    return {};
+}
+
+auto Font::is_glyph_ready(const AtlasGlyph& glyph) const -> bool
+{
+    return !m_asyncAtlas || m_asyncAtlas->is_glyph_ready(std::size_t(&glyph - m_data->glyphs.data()));
+}
+
+auto Font::is_glyph_ready(const GlyphInfo& glyph) const -> bool
+{
+    return !m_asyncAtlas || m_asyncAtlas->is_glyph_ready(glyph.AtlasIndex);
+}
+
+auto Font::is_atlas_complete() const -> bool
+{
+    return !m_asyncAtlas || m_asyncAtlas->is_finished();
+}
+
 void Font::set_texture_id(void* texture)
 {
     m_textureId = texture;
 }
 
-auto Font::get_geometry() const -> const msdf_atlas::FontGeometry&
+auto Font::get_texture_id() const -> void*
 {
-    return m_data->geometry;
+    return m_textureId;
+}
+
+auto Font::get_metrics() const -> const msdfgen::FontMetrics&
+{
+    return m_data->metrics;
+}
+
+auto Font::get_font_info() const -> const FontInfo&
+{
+    return m_glyphTable.get_info();
+}
+
+auto Font::get_glyph(msdf_atlas::unicode_t codepoint) const -> const AtlasGlyph*
+{
+    const auto* info = m_glyphTable.find(codepoint);
+    return info ? &m_data->glyphs[info->AtlasIndex] : nullptr;
+}
+
+auto Font::get_advance(double& advance, msdf_atlas::unicode_t codepoint1, msdf_atlas::unicode_t codepoint2) const -> bool
+{
+    const auto* glyph1 = m_glyphTable.find(codepoint1);
+    const auto* glyph2 = m_glyphTable.find(codepoint2);
+    if (!glyph1 || !glyph2)
+    {
+        return false;
+    }
+
+    advance = m_data->glyphs[glyph1->AtlasIndex].advance + m_glyphTable.get_kerning(glyph1->GlyphIndex, glyph2->GlyphIndex);
+    return true;
+}
+
+auto Font::measure(std::string_view text, float fontSize) const -> TextExtents
+{
+    return measure_lines(text, fontSize, {});
+}
+
+auto Font::measure_lines(std::string_view text, float fontSize, std::span<LineExtents> lines) const -> TextExtents
+{
+    const auto scale = get_font_scale(fontSize);
+
+    TextExtents extents{};
+    std::size_t begin = 0;
+    while (true)
+    {
+        auto end = text.find('\n', begin);
+        const auto lineEnd = end == std::string_view::npos ? text.size() : end;
+        auto line = text.substr(begin, lineEnd - begin);
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+
+        const auto width = measure_line(line) * scale;
+        extents.width = std::max(extents.width, width);
+        if (extents.lineCount < lines.size())
+        {
+            lines[extents.lineCount] = { begin, begin + line.size(), width };
+        }
+        ++extents.lineCount;
+
+        if (end == std::string_view::npos)
+        {
+            break;
+        }
+        begin = end + 1;
+    }
+
+    // The first line spans the font size, every following one adds the line spacing.
+    extents.height = fontSize + float(extents.lineCount - 1) * get_font_info().LineSpacing * scale;
+    return extents;
+}
+
+auto Font::measure_line(std::string_view text) const -> float
+{
+    const auto* fallback = m_glyphTable.find('?');
+
+    float width = 0.0f;
+    const GlyphInfo* previous = nullptr;
+    Utf8Reader reader(text);
+    std::uint32_t codepoint{};
+    while (reader.next(codepoint))
+    {
+        const auto* glyph = m_glyphTable.find(codepoint == '\t' ? ' ' : codepoint);
+        if (!glyph && !(glyph = fallback))
+        {
+            continue;
+        }
+
+        if (previous)
+        {
+            width += m_glyphTable.get_kerning(previous->GlyphIndex, glyph->GlyphIndex);
+        }
+        width += glyph->AdvanceX;
+        previous = glyph;
+    }
+    return width;
+}
+
+auto Font::get_font_scale(float fontSize) const -> float
+{
+    const auto& fontInfo = get_font_info();
+    return fontSize / (fontInfo.Ascender - fontInfo.Descender);
+}
+
+auto Font::request_glyph(msdf_atlas::unicode_t codepoint) -> const AtlasGlyph*
+{
+    if (const auto* glyph = get_glyph(codepoint))
+    {
+        return glyph;
+    }
+    if (!m_dynamicAtlas || m_dynamicAtlas->is_missing(codepoint))
+    {
+        return nullptr;
+    }
+
+    request_glyphs({ &codepoint, 1 });
+    return get_glyph(codepoint);
+}
+
+auto Font::request_glyph_info(msdf_atlas::unicode_t codepoint) -> const GlyphInfo*
+{
+    if (const auto* glyph = m_glyphTable.find(codepoint))
+    {
+        return glyph;
+    }
+    if (!m_dynamicAtlas || m_dynamicAtlas->is_missing(codepoint))
+    {
+        return nullptr;
+    }
+
+    request_glyphs({ &codepoint, 1 });
+    return m_glyphTable.find(codepoint);
+}
+
+void Font::request_glyphs(std::span<const msdf_atlas::unicode_t> codepoints)
+{
+    if (m_dynamicAtlas)
+    {
+        if (m_dynamicAtlas->add_glyphs(codepoints, *m_data))
+        {
+            m_glyphTable.build(*m_data);
+        }
+    }
 }
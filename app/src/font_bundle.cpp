@@ -0,0 +1,240 @@
+#include "font_bundle.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <type_traits>
+
+#define FONT_BUNDLE_MAGIC 0x42415346u  // "FSAB"
+#define FONT_BUNDLE_VERSION 4u  // Bumped whenever the contents change, not only the layout.
+#define FONT_BUNDLE_ALIGNMENT 16u
+#define FNV_OFFSET_BASIS 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+namespace
+{
+    struct BundleHeader
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t key;
+        msdfgen::FontMetrics metrics;
+        double emSize;
+        double pixelRange;
+        std::uint32_t textureWidth;
+        std::uint32_t textureHeight;
+        std::uint32_t textureChannels;
+        std::uint32_t glyphCount;
+        std::uint32_t kerningCount;
+        std::uint32_t reserved;
+        std::uint64_t glyphOffset;
+        std::uint64_t kerningOffset;
+        std::uint64_t textureOffset;
+        std::uint64_t textureSize;
+    };
+
+    static_assert(std::is_trivially_copyable_v<BundleHeader>);
+    static_assert(std::is_trivially_copyable_v<AtlasGlyph>);
+    static_assert(std::is_trivially_copyable_v<KerningPair>);
+
+    /* 64-bit FNV-1a */
+    class Hasher
+    {
+    public:
+        void add_bytes(const void* data, std::size_t size)
+        {
+            const auto* bytes = static_cast<const std::uint8_t*>(data);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                m_hash ^= bytes[i];
+                m_hash *= FNV_PRIME;
+            }
+        }
+
+        template <typename T>
+        void add(const T& value)
+        {
+            static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+            add_bytes(&value, sizeof(T));
+        }
+
+        auto get() const -> std::uint64_t { return m_hash; }
+
+    private:
+        std::uint64_t m_hash{ FNV_OFFSET_BASIS };
+    };
+
+    auto align_offset(std::uint64_t offset) -> std::uint64_t
+    {
+        return (offset + FONT_BUNDLE_ALIGNMENT - 1) & ~std::uint64_t(FONT_BUNDLE_ALIGNMENT - 1);
+    }
+
+    /* Returns a view of `count` elements at `offset` within the mapping, or an empty view if it does not fit. */
+    template <typename T>
+    auto get_section(const MappedFile& mapping, std::uint64_t offset, std::uint64_t count, bool& valid) -> std::span<const T>
+    {
+        if (offset % alignof(T) != 0 || offset > mapping.size() || count > (mapping.size() - offset) / sizeof(T))
+        {
+            valid = false;
+            return {};
+        }
+        return { reinterpret_cast<const T*>(mapping.data() + offset), std::size_t(count) };
+    }
+
+    /*
+     * Returns a temporary filename next to `filename` that no other writer uses, so writers of the same bundle, in this
+     * process or another, never write into one file. Unique within the process by a counter and across processes by a
+     * random salt.
+     */
+    auto make_temp_filename(const std::filesystem::path& filename) -> std::filesystem::path
+    {
+        static std::atomic<std::uint64_t> counter{ 0 };
+        static const auto salt = []
+        {
+            std::random_device device{};
+            return (std::uint64_t(device()) << 32) | device();
+        }();
+
+        std::ostringstream suffix{};
+        suffix << '.' << std::hex << std::setw(16) << std::setfill('0') << salt << '.' << counter.fetch_add(1) << ".tmp";
+        auto tempFilename = filename;
+        tempFilename += suffix.str();
+        return tempFilename;
+    }
+
+    template <typename T>
+    void write_section(std::ofstream& stream, std::uint64_t offset, std::span<const T> data)
+    {
+        static const char zeros[FONT_BUNDLE_ALIGNMENT]{};
+        stream.write(zeros, std::streamsize(offset - std::uint64_t(stream.tellp())));
+        stream.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size_bytes()));
+    }
+}
+
+auto compute_atlas_cache_key(std::span<const std::uint8_t> fontBytes, const FontConfig& config) -> std::uint64_t
+{
+    Hasher hasher{};
+    hasher.add(FONT_BUNDLE_VERSION);
+    hasher.add(fontBytes.size());
+    hasher.add_bytes(fontBytes.data(), fontBytes.size());
+
+    hasher.add(config.charsetRanges.size());
+    for (const auto& range : config.charsetRanges)
+    {
+        hasher.add(range.begin);
+        hasher.add(range.end);
+    }
+    hasher.add(config.atlasType);
+    hasher.add(config.emSize);
+    hasher.add(config.pixelRange);
+    hasher.add(config.miterLimit);
+    hasher.add(config.padding);
+    hasher.add(config.coloringSeed);
+    hasher.add(config.expensiveColoring);
+    return hasher.get();
+}
+
+auto get_atlas_cache_filename(const std::filesystem::path& cacheDirectory, std::uint64_t key) -> std::filesystem::path
+{
+    std::ostringstream name{};
+    name << std::hex << std::setw(16) << std::setfill('0') << key << ".fontbundle";
+    return cacheDirectory / name.str();
+}
+
+auto map_font_bundle(const std::filesystem::path& filename, std::uint64_t key, FontData& outData) -> bool
+{
+    MappedFile mapping{};
+    if (!mapping.open(filename) || mapping.size() < sizeof(BundleHeader))
+    {
+        return false;
+    }
+
+    const auto& header = *reinterpret_cast<const BundleHeader*>(mapping.data());
+    if (header.magic != FONT_BUNDLE_MAGIC || header.version != FONT_BUNDLE_VERSION || (key != 0 && header.key != key))
+    {
+        return false;
+    }
+
+    const auto expectedTextureSize = std::uint64_t(header.textureWidth) * header.textureHeight * header.textureChannels;
+    bool valid = header.textureSize == expectedTextureSize;
+    auto glyphs = get_section<AtlasGlyph>(mapping, header.glyphOffset, header.glyphCount, valid);
+    auto kerning = get_section<KerningPair>(mapping, header.kerningOffset, header.kerningCount, valid);
+    auto textureData = get_section<std::uint8_t>(mapping, header.textureOffset, header.textureSize, valid);
+    if (!valid)
+    {
+        return false;
+    }
+
+    FontData data{};
+    data.key = header.key;
+    data.metrics = header.metrics;
+    data.emSize = header.emSize;
+    data.pixelRange = header.pixelRange;
+    data.glyphs = glyphs;
+    data.kerning = kerning;
+    data.textureWidth = header.textureWidth;
+    data.textureHeight = header.textureHeight;
+    data.textureChannels = header.textureChannels;
+    data.textureData = textureData;
+    data.mapping = std::move(mapping);  // The views stay valid, moving the mapping does not remap it.
+
+    outData = std::move(data);
+    return true;
+}
+
+auto write_font_bundle(const std::filesystem::path& filename, const FontData& data) -> bool
+{
+    std::error_code error{};
+    if (filename.has_parent_path())
+    {
+        std::filesystem::create_directories(filename.parent_path(), error);
+    }
+
+    BundleHeader header{};
+    header.magic = FONT_BUNDLE_MAGIC;
+    header.version = FONT_BUNDLE_VERSION;
+    header.key = data.key;
+    header.metrics = data.metrics;
+    header.emSize = data.emSize;
+    header.pixelRange = data.pixelRange;
+    header.textureWidth = data.textureWidth;
+    header.textureHeight = data.textureHeight;
+    header.textureChannels = data.textureChannels;
+    header.glyphCount = std::uint32_t(data.glyphs.size());
+    header.kerningCount = std::uint32_t(data.kerning.size());
+    header.glyphOffset = align_offset(sizeof(BundleHeader));
+    header.kerningOffset = align_offset(header.glyphOffset + data.glyphs.size_bytes());
+    header.textureOffset = align_offset(header.kerningOffset + data.kerning.size_bytes());
+    header.textureSize = data.textureData.size();
+
+    // The bundle only appears under its name once complete, the rename replaces any bundle another writer finished.
+    const auto tempFilename = make_temp_filename(filename);
+    {
+        std::ofstream stream(tempFilename, std::ios::binary | std::ios::trunc);
+        if (!stream)
+        {
+            return false;
+        }
+
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        write_section(stream, header.glyphOffset, data.glyphs);
+        write_section(stream, header.kerningOffset, data.kerning);
+        write_section(stream, header.textureOffset, data.textureData);
+        if (!stream)
+        {
+            stream.close();
+            std::filesystem::remove(tempFilename, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempFilename, filename, error);
+    if (error)
+    {
+        std::filesystem::remove(tempFilename, error);
+        return false;
+    }
+    return true;
+}
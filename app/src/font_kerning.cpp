@@ -0,0 +1,451 @@
+#include "font_kerning.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#define TAG(a, b, c, d) ((std::uint32_t(a) << 24) | (std::uint32_t(b) << 16) | (std::uint32_t(c) << 8) | std::uint32_t(d))
+#define GPOS_LOOKUP_PAIR_ADJUSTMENT 2
+#define GPOS_LOOKUP_EXTENSION 9
+#define VALUE_FORMAT_X_ADVANCE 0x0004
+
+/* A kerning adjustment in font units, keyed by glyph index pair. */
+struct KerningEntry
+{
+    std::uint64_t key{};
+    std::int32_t value{};
+    bool replaces{};  // From a `kern` subtable with the override bit, the value replaces the ones before it.
+};
+
+static auto MakeKey(std::int32_t first, std::int32_t second) -> std::uint64_t
+{
+    return (std::uint64_t(std::uint32_t(first)) << 32) | std::uint32_t(second);
+}
+
+/* Big-endian reads, anything past the end of `data` reads as zero so malformed tables can't read out of bounds. */
+static auto ReadU16(std::span<const std::uint8_t> data, std::size_t offset) -> std::uint16_t
+{
+    if (offset + 2 > data.size())
+    {
+        return 0;
+    }
+    return std::uint16_t((data[offset] << 8) | data[offset + 1]);
+}
+
+static auto ReadI16(std::span<const std::uint8_t> data, std::size_t offset) -> std::int16_t
+{
+    return std::int16_t(ReadU16(data, offset));
+}
+
+static auto ReadU32(std::span<const std::uint8_t> data, std::size_t offset) -> std::uint32_t
+{
+    return (std::uint32_t(ReadU16(data, offset)) << 16) | ReadU16(data, offset + 2);
+}
+
+/* Returns the table tagged `tag` of the first font in `fontData`, or an empty span. */
+static auto FindTable(std::span<const std::uint8_t> fontData, std::uint32_t tag) -> std::span<const std::uint8_t>
+{
+    std::size_t fontOffset = 0;
+    if (ReadU32(fontData, 0) == TAG('t', 't', 'c', 'f'))
+    {
+        fontOffset = ReadU32(fontData, 12);
+    }
+
+    const auto tableCount = ReadU16(fontData, fontOffset + 4);
+    for (std::uint16_t i = 0; i < tableCount; ++i)
+    {
+        const auto record = fontOffset + 12 + std::size_t(i) * 16;
+        if (ReadU32(fontData, record) != tag)
+        {
+            continue;
+        }
+
+        const std::size_t offset = ReadU32(fontData, record + 8);
+        const std::size_t length = ReadU32(fontData, record + 12);
+        if (offset > fontData.size() || length > fontData.size() - offset)
+        {
+            return {};
+        }
+        return fontData.subspan(offset, length);
+    }
+    return {};
+}
+
+/* Returns the position of `glyphIndex` within the sorted `glyphIndices`, or -1. */
+static auto FindGlyph(std::span<const std::int32_t> glyphIndices, std::int32_t glyphIndex) -> std::ptrdiff_t
+{
+    auto it = std::lower_bound(glyphIndices.begin(), glyphIndices.end(), glyphIndex);
+    if (it == glyphIndices.end() || *it != glyphIndex)
+    {
+        return -1;
+    }
+    return it - glyphIndices.begin();
+}
+
+/*
+ * Calls `func(glyphIndex, coverageIndex)` for the glyphs of the coverage table at `offset`. Ranges only visit the glyphs
+ * of `glyphIndices` within them, so a damaged range can't spin through the whole glyph index space.
+ */
+template <typename Func>
+static void ForEachCoveredGlyph(std::span<const std::uint8_t> table,
+                                std::size_t offset,
+                                std::span<const std::int32_t> glyphIndices,
+                                Func&& func)
+{
+    const auto format = ReadU16(table, offset);
+    const auto count = ReadU16(table, offset + 2);
+    if (format == 1)
+    {
+        for (std::uint16_t i = 0; i < count; ++i)
+        {
+            func(std::int32_t(ReadU16(table, offset + 4 + std::size_t(i) * 2)), std::uint32_t(i));
+        }
+    }
+    else if (format == 2)
+    {
+        for (std::uint16_t i = 0; i < count; ++i)
+        {
+            const auto range = offset + 4 + std::size_t(i) * 6;
+            const auto start = ReadU16(table, range);
+            const auto end = ReadU16(table, range + 2);
+            const auto startCoverageIndex = ReadU16(table, range + 4);
+            for (auto it = std::lower_bound(glyphIndices.begin(), glyphIndices.end(), std::int32_t(start));
+                 it != glyphIndices.end() && *it <= end;
+                 ++it)
+            {
+                func(*it, std::uint32_t(startCoverageIndex + *it - start));
+            }
+        }
+    }
+}
+
+/* Returns the class of `glyphIndex` in the class definition table at `offset`. Glyphs that aren't listed are class 0. */
+static auto GetGlyphClass(std::span<const std::uint8_t> table, std::size_t offset, std::int32_t glyphIndex) -> std::uint16_t
+{
+    const auto format = ReadU16(table, offset);
+    if (format == 1)
+    {
+        const auto startGlyph = ReadU16(table, offset + 2);
+        const auto glyphCount = ReadU16(table, offset + 4);
+        if (glyphIndex < startGlyph || glyphIndex >= startGlyph + glyphCount)
+        {
+            return 0;
+        }
+        return ReadU16(table, offset + 6 + std::size_t(glyphIndex - startGlyph) * 2);
+    }
+    if (format == 2)
+    {
+        // Ranges are sorted by start glyph.
+        std::size_t low = 0;
+        std::size_t high = ReadU16(table, offset + 2);
+        while (low < high)
+        {
+            const auto middle = (low + high) / 2;
+            const auto range = offset + 4 + middle * 6;
+            if (glyphIndex < ReadU16(table, range))
+            {
+                high = middle;
+            }
+            else if (glyphIndex > ReadU16(table, range + 2))
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                return ReadU16(table, range + 4);
+            }
+        }
+    }
+    return 0;
+}
+
+/* Returns the byte offset of XAdvance within a value record of `valueFormat`, or -1 if it has none. */
+static auto GetXAdvanceOffset(std::uint16_t valueFormat) -> std::int32_t
+{
+    if (!(valueFormat & VALUE_FORMAT_X_ADVANCE))
+    {
+        return -1;
+    }
+    return std::popcount(std::uint16_t(valueFormat & (VALUE_FORMAT_X_ADVANCE - 1))) * 2;
+}
+
+/*
+ * Appends the pairs of a PairPos subtable at `offset` to `outEntries`.
+ * Within a lookup only the first subtable to match a pair applies: format 2 matches every pair whose first glyph it
+ * covers, so it claims those first glyphs in `claimedFirsts` for the subtables after it. Format 1 records are appended
+ * even when zero, so the caller can keep the first entry per pair.
+ */
+static void ReadPairAdjustment(std::span<const std::uint8_t> table,
+                               std::size_t offset,
+                               std::span<const std::int32_t> glyphIndices,
+                               std::vector<bool>& claimedFirsts,
+                               std::vector<KerningEntry>& outEntries)
+{
+    const auto format = ReadU16(table, offset);
+    const auto coverageOffset = offset + ReadU16(table, offset + 2);
+    const auto valueFormat1 = ReadU16(table, offset + 4);
+    const auto valueFormat2 = ReadU16(table, offset + 6);
+    const auto xAdvanceOffset = GetXAdvanceOffset(valueFormat1);
+    const auto valueRecord1Size = std::size_t(std::popcount(std::uint16_t(valueFormat1 & 0xFF))) * 2;
+    const auto valueRecord2Size = std::size_t(std::popcount(std::uint16_t(valueFormat2 & 0xFF))) * 2;
+    // Subtables without a horizontal advance adjustment still match the pairs they cover.
+    auto readXAdvance = [&](std::size_t valueRecord) -> std::int16_t
+    { return xAdvanceOffset < 0 ? std::int16_t(0) : ReadI16(table, valueRecord + xAdvanceOffset); };
+
+    if (format == 1)
+    {
+        const auto pairSetCount = ReadU16(table, offset + 8);
+        const auto pairValueRecordSize = 2 + valueRecord1Size + valueRecord2Size;
+        ForEachCoveredGlyph(table,
+                            coverageOffset,
+                            glyphIndices,
+                            [&](std::int32_t first, std::uint32_t coverageIndex)
+                            {
+                                const auto firstPosition = FindGlyph(glyphIndices, first);
+                                if (firstPosition < 0 || claimedFirsts[firstPosition] || coverageIndex >= pairSetCount)
+                                {
+                                    return;
+                                }
+
+                                const auto pairSet = offset + ReadU16(table, offset + 10 + std::size_t(coverageIndex) * 2);
+                                const auto pairValueCount = ReadU16(table, pairSet);
+                                for (std::uint16_t i = 0; i < pairValueCount; ++i)
+                                {
+                                    const auto record = pairSet + 2 + i * pairValueRecordSize;
+                                    const auto second = std::int32_t(ReadU16(table, record));
+                                    if (FindGlyph(glyphIndices, second) >= 0)
+                                    {
+                                        outEntries.push_back({ MakeKey(first, second), readXAdvance(record + 2) });
+                                    }
+                                }
+                            });
+    }
+    else if (format == 2)
+    {
+        const auto classDef1Offset = offset + ReadU16(table, offset + 8);
+        const auto classDef2Offset = offset + ReadU16(table, offset + 10);
+        const auto class1Count = ReadU16(table, offset + 12);
+        const auto class2Count = ReadU16(table, offset + 14);
+        const auto class2RecordSize = valueRecord1Size + valueRecord2Size;
+        const auto class1RecordSize = class2Count * class2RecordSize;
+
+        // The loaded glyphs of every second class.
+        std::vector<std::vector<std::int32_t>> class2Glyphs(class2Count);
+        for (auto glyphIndex : glyphIndices)
+        {
+            const auto class2 = GetGlyphClass(table, classDef2Offset, glyphIndex);
+            if (class2 < class2Count)
+            {
+                class2Glyphs[class2].push_back(glyphIndex);
+            }
+        }
+
+        std::vector<std::ptrdiff_t> newlyClaimed{};
+        ForEachCoveredGlyph(table,
+                            coverageOffset,
+                            glyphIndices,
+                            [&](std::int32_t first, std::uint32_t coverageIndex)
+                            {
+                                (void)(coverageIndex);
+                                const auto firstPosition = FindGlyph(glyphIndices, first);
+                                if (firstPosition < 0 || claimedFirsts[firstPosition])
+                                {
+                                    return;
+                                }
+                                newlyClaimed.push_back(firstPosition);
+
+                                const auto class1 = GetGlyphClass(table, classDef1Offset, first);
+                                if (class1 >= class1Count)
+                                {
+                                    return;
+                                }
+                                const auto class1Record = offset + 16 + class1 * class1RecordSize;
+                                for (std::uint16_t class2 = 0; class2 < class2Count; ++class2)
+                                {
+                                    const auto value = readXAdvance(class1Record + class2 * class2RecordSize);
+                                    if (value == 0)
+                                    {
+                                        continue;
+                                    }
+                                    for (auto second : class2Glyphs[class2])
+                                    {
+                                        outEntries.push_back({ MakeKey(first, second), value });
+                                    }
+                                }
+                            });
+        for (auto position : newlyClaimed)
+        {
+            claimedFirsts[position] = true;
+        }
+    }
+}
+
+/* Appends the pair adjustments of every GPOS lookup used by a `kern` feature. Returns false if there are none. */
+static auto ReadGposKerning(std::span<const std::uint8_t> gpos,
+                            std::span<const std::int32_t> glyphIndices,
+                            std::vector<KerningEntry>& outEntries) -> bool
+{
+    const auto featureList = std::size_t(ReadU16(gpos, 6));
+    const auto lookupList = std::size_t(ReadU16(gpos, 8));
+    if (featureList == 0 || lookupList == 0)
+    {
+        return false;
+    }
+
+    std::vector<std::uint16_t> lookupIndices{};
+    const auto featureCount = ReadU16(gpos, featureList);
+    for (std::uint16_t i = 0; i < featureCount; ++i)
+    {
+        const auto record = featureList + 2 + std::size_t(i) * 6;
+        if (ReadU32(gpos, record) != TAG('k', 'e', 'r', 'n'))
+        {
+            continue;
+        }
+
+        const auto feature = featureList + ReadU16(gpos, record + 4);
+        const auto lookupIndexCount = ReadU16(gpos, feature + 2);
+        for (std::uint16_t j = 0; j < lookupIndexCount; ++j)
+        {
+            lookupIndices.push_back(ReadU16(gpos, feature + 4 + std::size_t(j) * 2));
+        }
+    }
+    if (lookupIndices.empty())
+    {
+        return false;
+    }
+    // Lookups apply in lookup list order, each once however many features use it.
+    std::sort(lookupIndices.begin(), lookupIndices.end());
+    lookupIndices.erase(std::unique(lookupIndices.begin(), lookupIndices.end()), lookupIndices.end());
+
+    std::vector<bool> claimedFirsts{};
+    std::vector<KerningEntry> lookupEntries{};
+    for (auto lookupIndex : lookupIndices)
+    {
+        if (lookupIndex >= ReadU16(gpos, lookupList))
+        {
+            continue;
+        }
+
+        const auto lookup = lookupList + ReadU16(gpos, lookupList + 2 + std::size_t(lookupIndex) * 2);
+        const auto lookupType = ReadU16(gpos, lookup);
+        const auto subtableCount = ReadU16(gpos, lookup + 4);
+        claimedFirsts.assign(glyphIndices.size(), false);
+        lookupEntries.clear();
+        for (std::uint16_t i = 0; i < subtableCount; ++i)
+        {
+            auto subtable = lookup + ReadU16(gpos, lookup + 6 + std::size_t(i) * 2);
+            auto subtableType = lookupType;
+            if (lookupType == GPOS_LOOKUP_EXTENSION)
+            {
+                subtableType = ReadU16(gpos, subtable + 2);
+                subtable += ReadU32(gpos, subtable + 4);
+            }
+            if (subtableType == GPOS_LOOKUP_PAIR_ADJUSTMENT)
+            {
+                ReadPairAdjustment(gpos, subtable, glyphIndices, claimedFirsts, lookupEntries);
+            }
+        }
+
+        // The first subtable to match a pair wins within a lookup.
+        std::stable_sort(
+            lookupEntries.begin(), lookupEntries.end(), [](const KerningEntry& a, const KerningEntry& b) { return a.key < b.key; });
+        auto duplicates = std::unique(
+            lookupEntries.begin(), lookupEntries.end(), [](const KerningEntry& a, const KerningEntry& b) { return a.key == b.key; });
+        outEntries.insert(outEntries.end(), lookupEntries.begin(), duplicates);
+    }
+    return true;
+}
+
+/* Appends the pairs of every horizontal format 0 subtable of the `kern` table, in both the Microsoft & Apple layout. */
+static void ReadKernKerning(std::span<const std::uint8_t> kern,
+                            std::span<const std::int32_t> glyphIndices,
+                            std::vector<KerningEntry>& outEntries)
+{
+    const bool apple = ReadU32(kern, 0) == 0x00010000;
+    const auto subtableCount = apple ? ReadU32(kern, 4) : ReadU16(kern, 2);
+    std::size_t subtable = apple ? 8 : 4;
+    for (std::uint32_t i = 0; i < subtableCount && subtable < kern.size(); ++i)
+    {
+        std::size_t length{};
+        std::size_t header{};
+        bool horizontal{};
+        bool replaces{};
+        std::uint16_t format{};
+        if (apple)
+        {
+            length = ReadU32(kern, subtable);
+            const auto coverage = ReadU16(kern, subtable + 4);
+            format = coverage & 0xFF;
+            horizontal = !(coverage & 0xE000);  // Not vertical, cross-stream or variation.
+            header = 8;
+        }
+        else
+        {
+            length = ReadU16(kern, subtable + 2);
+            const auto coverage = ReadU16(kern, subtable + 4);
+            format = coverage >> 8;
+            horizontal = (coverage & 0x7) == 0x1;  // Horizontal, not minimum or cross-stream.
+            replaces = coverage & 0x8;
+            header = 6;
+        }
+
+        const auto pairCount = ReadU16(kern, subtable + header);
+        if (format == 0 && horizontal)
+        {
+            for (std::uint16_t j = 0; j < pairCount; ++j)
+            {
+                const auto pair = subtable + header + 8 + std::size_t(j) * 6;
+                const auto first = std::int32_t(ReadU16(kern, pair));
+                const auto second = std::int32_t(ReadU16(kern, pair + 2));
+                if (FindGlyph(glyphIndices, first) >= 0 && FindGlyph(glyphIndices, second) >= 0)
+                {
+                    outEntries.push_back({ MakeKey(first, second), ReadI16(kern, pair + 4), replaces });
+                }
+            }
+            // The 16-bit length of large format 0 subtables overflows, the pair count is reliable.
+            length = header + 8 + std::size_t(pairCount) * 6;
+        }
+        if (length == 0)
+        {
+            break;
+        }
+        subtable += length;
+    }
+}
+
+auto load_font_kerning(std::span<const std::uint8_t> fontData, std::span<const std::int32_t> glyphIndices, double fontScale)
+    -> std::vector<KerningPair>
+{
+    const auto head = FindTable(fontData, TAG('h', 'e', 'a', 'd'));
+    const auto unitsPerEm = ReadU16(head, 18);
+    if (unitsPerEm == 0 || glyphIndices.empty())
+    {
+        return {};
+    }
+
+    // Shapers only fall back to the kern table for fonts without GPOS kerning.
+    std::vector<KerningEntry> entries{};
+    if (!ReadGposKerning(FindTable(fontData, TAG('G', 'P', 'O', 'S')), glyphIndices, entries))
+    {
+        ReadKernKerning(FindTable(fontData, TAG('k', 'e', 'r', 'n')), glyphIndices, entries);
+    }
+
+    // Adjustments of separate lookups & kern subtables add up, unless a subtable overrides them. Stable, so the
+    // adjustments of a pair stay in subtable order.
+    std::stable_sort(entries.begin(), entries.end(), [](const KerningEntry& a, const KerningEntry& b) { return a.key < b.key; });
+    std::vector<KerningPair> kerning{};
+    const auto scale = fontScale / unitsPerEm;
+    for (std::size_t i = 0; i < entries.size();)
+    {
+        const auto key = entries[i].key;
+        std::int32_t value = 0;
+        for (; i < entries.size() && entries[i].key == key; ++i)
+        {
+            value = entries[i].replaces ? entries[i].value : value + entries[i].value;
+        }
+        if (value != 0)
+        {
+            kerning.push_back({ std::int32_t(key >> 32), std::int32_t(key & 0xFFFFFFFF), scale * value });
+        }
+    }
+    return kerning;
+}
@@ -0,0 +1,47 @@
+#include "font_library.hpp"
+
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+
+/* The FreeType instance of the calling thread, released when the thread exits. */
+static auto GetThreadFreetype() -> msdfgen::FreetypeHandle*
+{
+    static thread_local std::unique_ptr<msdfgen::FreetypeHandle, decltype(&msdfgen::deinitializeFreetype)> ft(
+        msdfgen::initializeFreetype(), &msdfgen::deinitializeFreetype);
+    assert(ft);
+    return ft.get();
+}
+
+FontLibrary::FontLibrary(ThreadPool& threadPool) : m_threadPool(threadPool) {}
+
+auto FontLibrary::load(const std::filesystem::path& fontFilename, const FontConfig& config) -> std::future<Font>
+{
+    return m_threadPool.submit(
+        [fontFilename, config]
+        {
+            MappedFile fontFile{};
+            if (!fontFile.open(fontFilename))
+            {
+                throw std::runtime_error("Failed to load font: " + fontFilename.string());
+            }
+            return Font(fontFile.bytes(), config, GetThreadFreetype());
+        });
+}
+
+auto FontLibrary::load_all(const std::vector<std::filesystem::path>& fontFilenames, const FontConfig& config)
+    -> std::vector<std::future<Font>>
+{
+    std::vector<std::future<Font>> futures{};
+    futures.reserve(fontFilenames.size());
+    for (const auto& fontFilename : fontFilenames)
+    {
+        futures.push_back(load(fontFilename, config));
+    }
+    return futures;
+}
+
+auto FontLibrary::get_thread_count() const -> std::uint32_t
+{
+    return m_threadPool.get_thread_count();
+}
@@ -0,0 +1,63 @@
+#include "gl_stream_buffer.hpp"
+
+#include <stdexcept>
+
+#define FENCE_WAIT_TIMEOUT 1000000000ull  // 1 second in nanoseconds.
+
+GlStreamBufferDevice::GlStreamBufferDevice(GLenum target)
+    : m_target(target)
+{
+}
+
+GlStreamBufferDevice::~GlStreamBufferDevice()
+{
+    release_storage();
+}
+
+auto GlStreamBufferDevice::map_storage(std::size_t size) -> std::uint8_t*
+{
+    release_storage();
+
+    // Coherent, so writes become visible to the GPU without flushing them.
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(m_target, m_buffer);
+    glBufferStorage(m_target, GLsizeiptr(size), nullptr, flags);
+    return static_cast<std::uint8_t*>(glMapBufferRange(m_target, 0, GLsizeiptr(size), flags));
+}
+
+void GlStreamBufferDevice::release_storage()
+{
+    if (m_buffer)
+    {
+        glBindBuffer(m_target, m_buffer);
+        glUnmapBuffer(m_target);
+        glDeleteBuffers(1, &m_buffer);
+        m_buffer = 0;
+    }
+}
+
+auto GlStreamBufferDevice::insert_fence() -> Fence
+{
+    return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void GlStreamBufferDevice::wait_fence(Fence fence)
+{
+    while (true)
+    {
+        // Flushing makes sure the fence gets submitted, otherwise the wait could never end.
+        switch (glClientWaitSync(static_cast<GLsync>(fence), GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_TIMEOUT))
+        {
+            case GL_ALREADY_SIGNALED:
+            case GL_CONDITION_SATISFIED: return;
+            case GL_WAIT_FAILED: throw std::runtime_error("Failed to wait for a stream buffer fence.");
+            default: break;
+        }
+    }
+}
+
+void GlStreamBufferDevice::delete_fence(Fence fence)
+{
+    glDeleteSync(static_cast<GLsync>(fence));
+}
@@ -0,0 +1,354 @@
+#include "gl_text_backend.hpp"
+#include "gl_utils.hpp"
+#include "font.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Expands one GlyphInstance into a quad, the corner comes from the vertex index of a 4 vertex triangle strip.
+const std::string MSDFTextVertexShaderSource = R"(
+#version 330 core
+#extension GL_ARB_separate_shader_objects : enable
+
+layout (location = 0) in vec2 in_position;
+layout (location = 1) in vec2 in_size;
+layout (location = 2) in vec4 in_texRect;
+layout (location = 3) in vec4 in_color;
+
+layout (location = 0) out vec4 out_color;
+layout (location = 1) out vec2 out_texCoord;
+
+uniform mat4 u_projMatrix;
+
+void main()
+{
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    out_color = in_color;
+    out_texCoord = vec2(mix(in_texRect.x, in_texRect.z, corner.x), mix(in_texRect.w, in_texRect.y, corner.y));
+    gl_Position = u_projMatrix * vec4(in_position + corner * in_size, 0.0, 1.0);
+}
+)";
+
+const std::string MSDFTextFragmentShaderSource = R"(
+#version 330 core
+#extension GL_ARB_separate_shader_objects : enable
+
+layout (location = 0) in vec4 in_color;
+layout (location = 1) in vec2 in_texCoord;
+
+layout(location = 0) out vec4 out_fragColor;
+
+uniform sampler2D u_fontAtlas;
+
+const float pxRange = 2; // set to distance fields pixel range
+
+float screenPxRange()
+{
+    vec2 unitRange = vec2(pxRange) / vec2(textureSize(u_fontAtlas, 0));
+    vec2 screenTexSize = vec2(1.0) / fwidth(in_texCoord);
+    return max(0.5 * dot(unitRange, screenTexSize), 1.0);
+}
+
+float median(float r, float g, float b)
+{
+    return max(min(r, g), min(max(r, g), b));
+}
+
+void main()
+{
+    vec3 msd = texture(u_fontAtlas, in_texCoord).rgb;
+    float sd = median(msd.r, msd.g, msd.b);
+    float screenPxDistance = screenPxRange() * (sd - 0.5);
+    float opacity = clamp(screenPxDistance + 0.5, 0.0, 1.0);
+    if(opacity == 0.0)
+        discard;
+
+    vec4 bgColor = vec4(0.0);
+    out_fragColor = mix(bgColor, in_color, opacity);
+}
+)";
+
+/* Points the attributes of the bound vertex array at the GlyphInstances of the bound array buffer. */
+static void SetInstanceAttributes()
+{
+    // One GlyphInstance per quad, positions & sizes are converted to float, texture coordinates & colors normalized.
+    const auto stride = GLsizei(sizeof(GlyphInstance));
+    glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, stride, (void*)(offsetof(GlyphInstance, x)));
+    glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_FALSE, stride, (void*)(offsetof(GlyphInstance, width)));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)(offsetof(GlyphInstance, u0)));
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(offsetof(GlyphInstance, color)));
+    for (GLuint attribute = 0; attribute < 4; ++attribute)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+}
+
+GlTextBackend::GlTextBackend(std::size_t instancesPerFrame)
+{
+    m_program = create_shader_program(MSDFTextVertexShaderSource, MSDFTextFragmentShaderSource);
+    m_projMatrixLocation = glGetUniformLocation(m_program, "u_projMatrix");
+
+    glGenVertexArrays(1, &m_vao);
+    glBindVertexArray(m_vao);
+
+    // Creating the storage leaves it bound for the attribute pointers.
+    m_buffer = std::make_unique<StreamBuffer>(m_bufferDevice, instancesPerFrame * sizeof(GlyphInstance));
+    SetInstanceAttributes();
+
+    // The retained buffer is created on first use.
+    glGenVertexArrays(1, &m_retainedVao);
+    glBindVertexArray(0);
+}
+
+GlTextBackend::~GlTextBackend()
+{
+    m_buffer.reset();
+    for (const auto& texture : m_textures)
+    {
+        glDeleteTextures(1, &texture->texture);
+    }
+    glDeleteBuffers(1, &m_retainedBuffer);
+    glDeleteVertexArrays(1, &m_retainedVao);
+    glDeleteVertexArrays(1, &m_vao);
+    glDeleteProgram(m_program);
+}
+
+void GlTextBackend::begin_frame()
+{
+    m_buffer->begin_frame();
+}
+
+void GlTextBackend::render(const TextDrawList& drawList, std::uint32_t viewportWidth, std::uint32_t viewportHeight)
+{
+    if (drawList.draws.empty())
+    {
+        return;
+    }
+
+    const auto instanceCount = drawList.instances.size();
+    auto* instances = m_buffer->reserve(sizeof(GlyphInstance) * instanceCount, sizeof(GlyphInstance));
+    if (!instances)
+    {
+        std::cerr << "Text stream buffer is full, dropping " << instanceCount << " glyphs." << std::endl;
+        return;
+    }
+    // Gathered by draw straight into the mapped buffer, the draw list's instances are still in the order they were added.
+    for (const auto& draw : drawList.draws)
+    {
+        drawList.gather(draw, reinterpret_cast<GlyphInstance*>(instances) + draw.firstInstance);
+    }
+    m_buffer->commit(sizeof(GlyphInstance) * instanceCount);
+
+    begin_draws(m_vao, viewportWidth, viewportHeight);
+    const auto baseInstance = GLuint(m_buffer->get_reserved_offset() / sizeof(GlyphInstance));
+    for (const auto& draw : drawList.draws)
+    {
+        if (draw.scissor == TEXT_NO_SCISSOR)
+        {
+            glDisable(GL_SCISSOR_TEST);
+        }
+        else
+        {
+            // GL's window coordinates start in the bottom left corner.
+            const auto& rect = drawList.scissors[draw.scissor];
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(rect.x, GLint(viewportHeight) - (rect.y + rect.height), rect.width, rect.height);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, update_atlas_texture(*drawList.atlases[draw.atlas]));
+        glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, GLsizei(draw.instanceCount), baseInstance + draw.firstInstance);
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+    glBindVertexArray(0);
+}
+
+void GlTextBackend::render(std::span<TextObject* const> objects, std::uint32_t viewportWidth, std::uint32_t viewportHeight)
+{
+    // Upload whatever changed since the last frame, static objects are skipped after a version compare.
+    for (auto* object : objects)
+    {
+        object->update();
+
+        auto& allocation = object->get_allocation();
+        if (allocation.backend && allocation.backend != this)
+        {
+            throw std::runtime_error("A text object can only be drawn by one backend.");
+        }
+        if (allocation.version == object->get_version())
+        {
+            continue;
+        }
+        allocation.version = object->get_version();
+
+        const auto instances = object->get_instances();
+        const auto instanceCount = std::uint32_t(instances.size());
+        if (instanceCount > allocation.capacity)
+        {
+            if (allocation.capacity)
+            {
+                free_retained(allocation.firstInstance, allocation.capacity);
+            }
+            const auto granularity = GL_TEXT_RETAINED_GRANULARITY;
+            const auto capacity = (instanceCount + granularity - 1) / granularity * granularity;
+            allocation.firstInstance = allocate_retained(capacity);
+            allocation.capacity = capacity;
+            allocation.backend = this;
+        }
+        if (instanceCount > 0)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, m_retainedBuffer);
+            glBufferSubData(GL_ARRAY_BUFFER, GLintptr(sizeof(GlyphInstance) * allocation.firstInstance),
+                            GLsizeiptr(sizeof(GlyphInstance) * instanceCount), instances.data());
+        }
+    }
+
+    begin_draws(m_retainedVao, viewportWidth, viewportHeight);
+    for (std::size_t i = 0; i < objects.size();)
+    {
+        // Neighbours of one font whose ranges happen to touch are drawn together.
+        auto* font = objects[i]->get_font();
+        const auto first = objects[i]->get_allocation().firstInstance;
+        auto count = std::uint32_t(objects[i]->get_instances().size());
+        for (++i; i < objects.size(); ++i)
+        {
+            const auto& next = *objects[i];
+            if (next.get_font() != font || next.get_allocation().firstInstance != first + count)
+            {
+                break;
+            }
+            count += std::uint32_t(next.get_instances().size());
+        }
+
+        if (count > 0)
+        {
+            glBindTexture(GL_TEXTURE_2D, update_atlas_texture(*font));
+            glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, GLsizei(count), first);
+        }
+    }
+    glBindVertexArray(0);
+}
+
+void GlTextBackend::end_frame()
+{
+    m_buffer->end_frame();
+}
+
+void GlTextBackend::release(TextObject& object)
+{
+    auto& allocation = object.get_allocation();
+    if (allocation.capacity)
+    {
+        free_retained(allocation.firstInstance, allocation.capacity);
+    }
+    allocation = {};
+}
+
+void GlTextBackend::begin_draws(GLuint vao, std::uint32_t viewportWidth, std::uint32_t viewportHeight)
+{
+    // Orthographic, with the origin in the top left corner & y pointing down.
+    const float width = float(viewportWidth);
+    const float height = float(viewportHeight);
+    const float projMatrix[16] = {
+        2.0f / width, 0.0f, 0.0f, 0.0f, 0.0f, -2.0f / height, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -1.0f, 1.0f, 0.0f, 1.0f,
+    };
+
+    glUseProgram(m_program);
+    glBindVertexArray(vao);
+    glUniformMatrix4fv(m_projMatrixLocation, 1, GL_FALSE, projMatrix);
+}
+
+auto GlTextBackend::update_atlas_texture(Font& font) -> GLuint
+{
+    // On-demand fonts may have added glyphs while laying out, async fonts whenever a batch finishes.
+    auto* atlas = static_cast<AtlasTexture*>(font.get_texture_id());
+    if (atlas && atlas->version == font.get_texture_version())
+    {
+        return atlas->texture;
+    }
+
+    // The version is read first, so changes made while uploading trigger another upload.
+    auto textureLock = font.lock_texture();
+    const auto version = font.get_texture_version();
+    const GLenum format = font.get_texture_channels() == 4 ? GL_RGBA : GL_RGB;
+    if (!atlas)
+    {
+        atlas = m_textures.emplace_back(std::make_unique<AtlasTexture>()).get();
+        atlas->texture = create_texture_2d(font.get_texture_width(), font.get_texture_height(), font.get_texture_data(), format, false);
+        font.set_texture_id(atlas);
+    }
+    else
+    {
+        update_texture_2d(atlas->texture, font.get_texture_width(), font.get_texture_height(), font.get_texture_data(), format, false);
+    }
+    atlas->version = version;
+
+    return atlas->texture;
+}
+
+auto GlTextBackend::allocate_retained(std::uint32_t count) -> std::uint32_t
+{
+    auto range =
+        std::find_if(m_retainedFree.begin(), m_retainedFree.end(), [count](const RetainedRange& free) { return free.count >= count; });
+    if (range == m_retainedFree.end())
+    {
+        grow_retained(m_retainedCapacity + count);
+        range = m_retainedFree.end() - 1;  // Growing extends the last free range, which is now big enough.
+    }
+
+    const auto first = range->first;
+    range->first += count;
+    range->count -= count;
+    if (range->count == 0)
+    {
+        m_retainedFree.erase(range);
+    }
+    return first;
+}
+
+void GlTextBackend::free_retained(std::uint32_t first, std::uint32_t count)
+{
+    auto next = std::lower_bound(m_retainedFree.begin(), m_retainedFree.end(), first,
+                                 [](const RetainedRange& free, std::uint32_t value) { return free.first < value; });
+    next = m_retainedFree.insert(next, { first, count });
+
+    // Merge with the following & preceding ranges, so they never touch.
+    if (next + 1 != m_retainedFree.end() && next->first + next->count == (next + 1)->first)
+    {
+        next->count += (next + 1)->count;
+        m_retainedFree.erase(next + 1);
+    }
+    if (next != m_retainedFree.begin() && (next - 1)->first + (next - 1)->count == next->first)
+    {
+        (next - 1)->count += next->count;
+        m_retainedFree.erase(next);
+    }
+}
+
+void GlTextBackend::grow_retained(std::uint32_t minimumCapacity)
+{
+    const auto capacity = std::max({ minimumCapacity, m_retainedCapacity * 2, 1024u });
+
+    GLuint buffer{};
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(sizeof(GlyphInstance) * capacity), nullptr, GL_DYNAMIC_DRAW);
+    if (m_retainedBuffer)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, m_retainedBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, GLsizeiptr(sizeof(GlyphInstance) * m_retainedCapacity));
+        glDeleteBuffers(1, &m_retainedBuffer);
+    }
+    m_retainedBuffer = buffer;
+
+    glBindVertexArray(m_retainedVao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_retainedBuffer);
+    SetInstanceAttributes();
+    glBindVertexArray(0);
+
+    free_retained(m_retainedCapacity, capacity - m_retainedCapacity);
+    m_retainedCapacity = capacity;
+}
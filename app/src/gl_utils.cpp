@@ -0,0 +1,80 @@
+#include "gl_utils.hpp"
+
+#include <iostream>
+
+GLuint compile_shader(const char* shaderSource, GLenum shaderType)
+{
+    GLuint shaderHandle = glCreateShader(shaderType);
+
+    glShaderSource(shaderHandle, 1, &shaderSource, nullptr);
+    glCompileShader(shaderHandle);
+
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shaderHandle, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(shaderHandle, 512, nullptr, infoLog);
+        std::cerr << "Error while compiling shader: " << infoLog << std::endl;
+    }
+
+    return shaderHandle;
+}
+
+GLuint create_shader_program(const std::string& vertexSource, const std::string& fragmentSource)
+{
+    auto vertexShader = compile_shader(vertexSource.c_str(), GL_VERTEX_SHADER);
+    auto fragmentShader = compile_shader(fragmentSource.c_str(), GL_FRAGMENT_SHADER);
+
+    GLuint shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+
+    int success;
+    char infoLog[512];
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cerr << "Error while linking shaders: " << infoLog << std::endl;
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    return shaderProgram;
+}
+
+void update_texture_2d(GLuint texture, std::uint32_t width, std::uint32_t height, const void* data, GLenum format, bool generateMipMaps)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // Atlas rows are tightly packed, an RGB row is not necessarily a multiple of 4 bytes.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    const int mipMapLevel = 0;
+    const GLenum sourceFormat = format;
+    const GLenum sourceDataType = GL_UNSIGNED_BYTE;
+    glTexImage2D(GL_TEXTURE_2D, mipMapLevel, sourceFormat, width, height, 0, sourceFormat, sourceDataType, data);
+    if (generateMipMaps)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+}
+
+GLuint create_texture_2d(std::uint32_t width, std::uint32_t height, const void* data, GLenum format, bool generateMipMaps)
+{
+    GLuint texture{};
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    update_texture_2d(texture, width, height, data, format, generateMipMaps);
+
+    return texture;
+}
@@ -0,0 +1,96 @@
+#include "glyph_table.hpp"
+#include "font.hpp"
+
+#include <algorithm>
+#include <bit>
+
+/* Returns a power of two table size that keeps the load factor at or below one half. */
+static auto GetTableSize(std::size_t count) -> std::size_t
+{
+    return std::bit_ceil(std::max<std::size_t>(count * 2, 2));
+}
+
+void GlyphTable::build(const FontData& data)
+{
+    const auto& metrics = data.metrics;
+    m_info.EmSize = float(data.emSize);
+    m_info.PixelRange = float(data.pixelRange);
+    m_info.Ascender = float(metrics.ascenderY);
+    m_info.Descender = float(metrics.descenderY);
+    m_info.LineSpacing = float(metrics.lineHeight);
+    m_info.LineGap = float(metrics.lineHeight - (metrics.ascenderY - metrics.descenderY));
+    m_info.MaxAdvanceWidth = 0.0f;
+
+    // Atlas bounds are in texels, with y pointing up like texture coordinates.
+    const auto texelWidth = data.textureWidth ? 1.0 / data.textureWidth : 0.0;
+    const auto texelHeight = data.textureHeight ? 1.0 / data.textureHeight : 0.0;
+    m_glyphs.clear();
+    m_glyphs.reserve(data.glyphs.size());
+    m_direct.fill(EMPTY);
+    std::size_t hashedCount = 0;
+    for (std::size_t i = 0; i < data.glyphs.size(); ++i)
+    {
+        const auto& glyph = data.glyphs[i];
+        auto& info = m_glyphs.emplace_back();
+        info.Quad.X0 = float(glyph.planeLeft);
+        info.Quad.Y0 = float(-glyph.planeBottom);
+        info.Quad.X1 = float(glyph.planeRight);
+        info.Quad.Y1 = float(-glyph.planeTop);
+        info.Quad.U0 = float(glyph.atlasLeft * texelWidth);
+        info.Quad.V0 = float(glyph.atlasBottom * texelHeight);
+        info.Quad.U1 = float(glyph.atlasRight * texelWidth);
+        info.Quad.V1 = float(glyph.atlasTop * texelHeight);
+        info.AdvanceX = float(glyph.advance);
+        info.GlyphIndex = glyph.index;
+        info.Codepoint = glyph.codepoint;
+        info.AtlasIndex = std::uint32_t(i);
+        m_info.MaxAdvanceWidth = std::max(m_info.MaxAdvanceWidth, info.AdvanceX);
+
+        if (glyph.codepoint < GLYPH_TABLE_DIRECT_SIZE)
+        {
+            m_direct[glyph.codepoint] = std::uint32_t(i);
+        }
+        else
+        {
+            ++hashedCount;
+        }
+    }
+
+    m_slots.clear();
+    if (hashedCount > 0)
+    {
+        m_slots.resize(GetTableSize(hashedCount));
+        m_slotMask = std::uint32_t(m_slots.size() - 1);
+        for (const auto& info : m_glyphs)
+        {
+            if (info.Codepoint < GLYPH_TABLE_DIRECT_SIZE)
+            {
+                continue;
+            }
+
+            auto slot = Hash(info.Codepoint) & m_slotMask;
+            while (m_slots[slot].glyph != EMPTY)
+            {
+                slot = (slot + 1) & m_slotMask;
+            }
+            m_slots[slot] = { info.Codepoint, info.AtlasIndex };
+        }
+    }
+
+    m_kerning.clear();
+    if (!data.kerning.empty())
+    {
+        m_kerning.resize(GetTableSize(data.kerning.size()));
+        m_kerningMask = std::uint32_t(m_kerning.size() - 1);
+        for (const auto& pair : data.kerning)
+        {
+            const auto key = MakeKey(pair.first, pair.second);
+            auto slot = Hash(key) & m_kerningMask;
+            while (m_kerning[slot].key != EMPTY_KEY)
+            {
+                slot = (slot + 1) & m_kerningMask;
+            }
+            m_kerning[slot] = { key, float(pair.advance) };
+        }
+    }
+}
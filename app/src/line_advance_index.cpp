@@ -0,0 +1,107 @@
+#include "line_advance_index.hpp"
+#include "font.hpp"
+#include "utf8_reader.hpp"
+
+#include <algorithm>
+
+/* Finds the glyph a codepoint is drawn with, a space for tabs & '?' for codepoints the atlas lacks. */
+static auto FindGlyph(const Font& font, std::uint32_t codepoint) -> const GlyphInfo*
+{
+    const auto* glyph = font.get_glyph_info(codepoint == '\t' ? ' ' : codepoint);
+    return glyph ? glyph : font.get_glyph_info('?');
+}
+
+void LineAdvanceIndex::build(const Font& font, std::string_view line)
+{
+    m_codepoints.clear();
+    m_codepoints.reserve(line.size());
+    Utf8Reader reader(line);
+    std::uint32_t codepoint{};
+    while (reader.next(codepoint))
+    {
+        m_codepoints.push_back(codepoint);
+    }
+
+    m_advances.resize(m_codepoints.size());
+    m_positions.resize(m_codepoints.size() + 1);
+    update(font, 0, m_codepoints.size());
+}
+
+void LineAdvanceIndex::replace(const Font& font, std::size_t first, std::size_t removeCount, std::string_view text)
+{
+    first = std::min(first, m_codepoints.size());
+    removeCount = std::min(removeCount, m_codepoints.size() - first);
+
+    // Counted first, so the tail of the line is moved once.
+    std::size_t insertCount = 0;
+    std::uint32_t codepoint{};
+    for (Utf8Reader reader(text); reader.next(codepoint);)
+    {
+        ++insertCount;
+    }
+
+    m_codepoints.erase(m_codepoints.begin() + first, m_codepoints.begin() + first + removeCount);
+    m_codepoints.insert(m_codepoints.begin() + first, insertCount, 0);
+    auto insertAt = first;
+    for (Utf8Reader reader(text); reader.next(codepoint);)
+    {
+        m_codepoints[insertAt++] = codepoint;
+    }
+
+    // Advances after the edit keep their value, they only move.
+    m_advances.erase(m_advances.begin() + first, m_advances.begin() + first + removeCount);
+    m_advances.insert(m_advances.begin() + first, insertCount, 0.0f);
+    m_positions.resize(m_codepoints.size() + 1);
+
+    // The character in front of the edit kerns with a different neighbour now.
+    update(font, first > 0 ? first - 1 : 0, insertAt);
+}
+
+auto LineAdvanceIndex::get_caret_x(std::size_t character) const -> float
+{
+    return m_positions[std::min(character, m_codepoints.size())];
+}
+
+auto LineAdvanceIndex::hit_test(float x) const -> std::size_t
+{
+    // The first caret past x, or the one before it if that is closer.
+    const auto next = std::size_t(std::upper_bound(m_positions.begin(), m_positions.end(), x) - m_positions.begin());
+    if (next == 0)
+    {
+        return 0;
+    }
+    if (next == m_positions.size())
+    {
+        return m_codepoints.size();
+    }
+    return x - m_positions[next - 1] <= m_positions[next] - x ? next - 1 : next;
+}
+
+void LineAdvanceIndex::update(const Font& font, std::size_t first, std::size_t end)
+{
+    const auto count = m_codepoints.size();
+    end = std::min(end, count);
+
+    const GlyphInfo* glyph = first < end ? FindGlyph(font, m_codepoints[first]) : nullptr;
+    for (auto i = first; i < end; ++i)
+    {
+        const auto* next = i + 1 < count ? FindGlyph(font, m_codepoints[i + 1]) : nullptr;
+        float advance = 0.0f;
+        if (glyph)
+        {
+            advance = glyph->AdvanceX;
+            if (next)
+            {
+                advance += font.get_kerning(*glyph, *next);
+            }
+        }
+        m_advances[i] = advance;
+        glyph = next;
+    }
+
+    // Same order of additions as a full build, so an edited index matches a rebuilt one exactly.
+    for (auto i = first; i < count; ++i)
+    {
+        m_positions[i + 1] = m_positions[i] + m_advances[i];
+    }
+}
@@ -0,0 +1,221 @@
+#include "paragraph_layout.hpp"
+#include "font.hpp"
+#include "text_batch.hpp"
+#include "utf8_reader.hpp"
+
+#include <algorithm>
+
+ParagraphLayout::ParagraphLayout(Font& font, float fontSize, float maxWidth, TextAlign align)
+    : m_font(&font),
+      m_fontSize(fontSize),
+      m_maxWidth(maxWidth),
+      m_align(align)
+{
+    layout_all();
+}
+
+void ParagraphLayout::set_text(std::string_view text)
+{
+    m_text = text;
+    layout_all();
+}
+
+void ParagraphLayout::replace(std::size_t offset, std::size_t removeCount, std::string_view text)
+{
+    offset = std::min(offset, m_text.size());
+    removeCount = std::min(removeCount, m_text.size() - offset);
+    m_text.replace(offset, removeCount, text);
+
+    // Lines read past their end, into the word they overflowed at & past a '\r' to see if a '\n' follows. So the edit
+    // may change the last line beginning before it & the line in front of that, both are laid out again.
+    const auto touched = offset > 0 && m_text[offset - 1] == '\r' ? offset - 1 : offset;
+    auto line = std::size_t(std::lower_bound(m_lines.begin(), m_lines.end(), touched,
+                                             [](const ParagraphLine& line, std::size_t value) { return line.begin < value; })
+                            - m_lines.begin());
+    line = line > 1 ? line - 2 : 0;
+
+    // Lines only depend on the text from where they begin, so once a line begins past the edit where an old one did,
+    // moved by the edit, the old lines from there on are still valid.
+    const auto oldEditEnd = offset + removeCount;
+    const auto delta = std::ptrdiff_t(text.size()) - std::ptrdiff_t(removeCount);
+    auto oldLines = std::move(m_lines);
+    m_lines.assign(oldLines.begin(), oldLines.begin() + std::ptrdiff_t(line));
+    auto reuse = line;
+
+    m_relaidLineCount = 0;
+    auto begin = line < oldLines.size() ? oldLines[line].begin : 0;
+    while (true)
+    {
+        const auto laidOut = layout_line(begin);
+        m_lines.push_back(laidOut);
+        ++m_relaidLineCount;
+        begin = laidOut.next;
+        if (begin > m_text.size())
+        {
+            break;
+        }
+
+        while (reuse < oldLines.size() && (oldLines[reuse].begin < oldEditEnd || oldLines[reuse].begin + delta < begin))
+        {
+            ++reuse;
+        }
+        if (reuse < oldLines.size() && oldLines[reuse].begin + delta == begin)
+        {
+            for (; reuse < oldLines.size(); ++reuse)
+            {
+                auto moved = oldLines[reuse];
+                moved.begin += delta;
+                moved.end += delta;
+                moved.next += delta;
+                m_lines.push_back(moved);
+            }
+            break;
+        }
+    }
+}
+
+void ParagraphLayout::set_font_size(float fontSize)
+{
+    if (m_fontSize != fontSize)
+    {
+        m_fontSize = fontSize;
+        layout_all();
+    }
+}
+
+void ParagraphLayout::set_max_width(float maxWidth)
+{
+    if (m_maxWidth != maxWidth)
+    {
+        m_maxWidth = maxWidth;
+        layout_all();
+    }
+}
+
+auto ParagraphLayout::get_line_height() const -> float
+{
+    return m_font->get_font_info().LineSpacing * m_font->get_font_scale(m_fontSize);
+}
+
+void ParagraphLayout::draw(TextBatch& batch, float x, float y, std::uint32_t color) const
+{
+    const auto lineHeight = get_line_height();
+    for (const auto& line : m_lines)
+    {
+        auto lineX = x;
+        switch (m_align)
+        {
+            case TextAlign::Left: break;
+            case TextAlign::Center: lineX += (m_maxWidth - line.width) * 0.5f; break;
+            case TextAlign::Right: lineX += m_maxWidth - line.width; break;
+        }
+
+        if (line.end > line.begin)
+        {
+            batch.add_text(*m_font, lineX, y, std::string_view(m_text).substr(line.begin, line.end - line.begin), m_fontSize, color);
+        }
+        y += lineHeight;
+    }
+}
+
+auto ParagraphLayout::layout_line(std::size_t begin) const -> ParagraphLine
+{
+    const auto scale = m_font->get_font_scale(m_fontSize);
+    const auto maxWidth = m_maxWidth / scale;
+
+    // Widths are in ems until the line is done. `content` ends at the last character that isn't a space.
+    ParagraphLine line{ begin, begin, begin, 0.0f };
+    ParagraphLine lastBreak{ begin, begin, begin, 0.0f };  // Where the line ends if it breaks at the last spaces.
+    float x = 0.0f;
+    float content = 0.0f;
+
+    // Glyphs are requested like drawing does, so OnDemand fonts measure the glyphs they draw. The previous glyph is
+    // copied, requesting a glyph may move it.
+    GlyphInfo previous{};
+    bool hasPrevious = false;
+
+    Utf8Reader reader(std::string_view(m_text).substr(begin));
+    std::uint32_t codepoint{};
+    auto characterBegin = begin;
+    while (reader.next(codepoint))
+    {
+        const auto characterEnd = begin + reader.get_offset();
+        if (codepoint == '\n')
+        {
+            line.next = characterEnd;
+            line.width = content * scale;
+            return line;
+        }
+        if (codepoint == '\r' && (characterEnd == m_text.size() || m_text[characterEnd] == '\n'))
+        {
+            // Part of the line break, like Font::measure it is neither measured nor drawn.
+            line.next = characterEnd == m_text.size() ? m_text.size() + 1 : characterEnd + 1;
+            line.width = content * scale;
+            return line;
+        }
+
+        // Tabs are drawn as spaces, see write_text_instances.
+        const bool isSpace = codepoint == ' ' || codepoint == '\t';
+        const auto* glyph = m_font->request_glyph_info(isSpace ? ' ' : codepoint);
+        glyph = glyph ? glyph : m_font->request_glyph_info('?');
+        auto advance = glyph ? glyph->AdvanceX : 0.0f;
+        if (hasPrevious && glyph)
+        {
+            advance += m_font->get_kerning(previous, *glyph);
+        }
+
+        if (isSpace)
+        {
+            // The first space after a word ends the line there, the next line begins after the last space.
+            if (lastBreak.next != characterBegin || lastBreak.end == begin)
+            {
+                lastBreak.end = line.end;
+                lastBreak.width = content;
+            }
+            lastBreak.next = characterEnd;
+        }
+        else
+        {
+            if (x + advance > maxWidth && line.end > begin)
+            {
+                if (lastBreak.end > begin)
+                {
+                    lastBreak.width *= scale;
+                    return lastBreak;
+                }
+
+                // A word wider than the paragraph is broken where it overflows.
+                line.next = characterBegin;
+                line.width = content * scale;
+                return line;
+            }
+            line.end = characterEnd;
+            content = x + advance;
+        }
+
+        x += advance;
+        if (glyph)
+        {
+            previous = *glyph;
+            hasPrevious = true;
+        }
+        characterBegin = characterEnd;
+    }
+
+    line.next = m_text.size() + 1;  // Past the end, no line follows.
+    line.width = content * scale;
+    return line;
+}
+
+void ParagraphLayout::layout_all()
+{
+    m_lines.clear();
+    std::size_t begin = 0;
+    while (begin <= m_text.size())
+    {
+        const auto line = layout_line(begin);
+        m_lines.push_back(line);
+        begin = line.next;
+    }
+    m_relaidLineCount = m_lines.size();
+}
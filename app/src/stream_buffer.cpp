@@ -0,0 +1,85 @@
+#include "stream_buffer.hpp"
+
+#include <stdexcept>
+
+StreamBuffer::StreamBuffer(StreamBufferDevice& device, std::size_t frameSize)
+    : m_device(device),
+      m_frameSize(frameSize)
+{
+    if (frameSize == 0)
+    {
+        throw std::runtime_error("Stream buffer frames can't be empty.");
+    }
+
+    m_storage = m_device.map_storage(frameSize * STREAM_BUFFER_FRAME_COUNT);
+    if (!m_storage)
+    {
+        throw std::runtime_error("Failed to map stream buffer storage.");
+    }
+    m_offset = get_frame_offset() + m_frameSize;  // Nothing fits until begin_frame.
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    // Waiting isn't needed, a fence can be deleted while pending and the storage outlives the commands using it.
+    for (auto fence : m_fences)
+    {
+        if (fence)
+        {
+            m_device.delete_fence(fence);
+        }
+    }
+    m_device.release_storage();
+}
+
+void StreamBuffer::begin_frame()
+{
+    m_frame = (m_frame + 1) % STREAM_BUFFER_FRAME_COUNT;
+    if (auto& fence = m_fences[m_frame])
+    {
+        m_device.wait_fence(fence);
+        m_device.delete_fence(fence);
+        fence = nullptr;
+    }
+
+    m_offset = get_frame_offset();
+    m_reservedOffset = m_offset;
+    m_reservedSize = 0;
+}
+
+void StreamBuffer::end_frame()
+{
+    auto& fence = m_fences[m_frame];
+    if (fence)
+    {
+        // end_frame without begin_frame, the old fence covers less than the new one.
+        m_device.delete_fence(fence);
+    }
+    fence = m_device.insert_fence();
+}
+
+auto StreamBuffer::reserve(std::size_t size, std::size_t alignment) -> std::uint8_t*
+{
+    const auto offset = alignment > 1 ? (m_offset + alignment - 1) / alignment * alignment : m_offset;
+    const auto frameEnd = get_frame_offset() + m_frameSize;
+    if (offset > frameEnd || size > frameEnd - offset)
+    {
+        m_reservedSize = 0;
+        return nullptr;
+    }
+
+    m_reservedOffset = offset;
+    m_reservedSize = size;
+    return m_storage + offset;
+}
+
+void StreamBuffer::commit(std::size_t size)
+{
+    if (size > m_reservedSize)
+    {
+        throw std::runtime_error("Committed more than was reserved.");
+    }
+
+    m_offset = m_reservedOffset + size;
+    m_reservedSize = 0;
+}
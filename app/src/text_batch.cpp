@@ -0,0 +1,159 @@
+#include "text_batch.hpp"
+#include "font.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void TextBatch::add_text(Font& font, float x, float y, std::string_view text, float fontSize, std::uint32_t color)
+{
+    const auto firstInstance = std::uint32_t(m_instances.size());
+    append_text_instances(m_instances, font, x, y, text, fontSize, color, &m_clip);
+    add_command(font, firstInstance);
+}
+
+void TextBatch::add_run(Font& font, std::span<const GlyphInstance> run, float x, float y, std::uint32_t color)
+{
+    const auto firstInstance = std::uint32_t(m_instances.size());
+    const auto dx = std::int32_t(std::lround(x));
+    const auto dy = std::int32_t(std::lround(y));
+    m_instances.resize(firstInstance + run.size());
+    auto count = std::size_t(0);
+    for (const auto& glyph : run)
+    {
+        auto& instance = m_instances[firstInstance + count];
+        instance = glyph;
+        instance.x = std::int16_t(std::clamp(instance.x + dx, -32768, 32767));
+        instance.y = std::int16_t(std::clamp(instance.y + dy, -32768, 32767));
+        instance.color = color;
+        if (clip_glyph_instance(instance, m_clip))
+        {
+            ++count;
+        }
+    }
+    m_instances.resize(firstInstance + count);
+    add_command(font, firstInstance);
+}
+
+void TextBatch::set_viewport(std::int32_t width, std::int32_t height)
+{
+    m_viewport = { 0, 0, width, height };
+    update_clip();
+}
+
+void TextBatch::set_scissor(const ScissorRect& rect)
+{
+    const auto it = std::find(m_scissors.begin(), m_scissors.end(), rect);
+    m_scissor = std::uint32_t(it - m_scissors.begin());
+    if (it == m_scissors.end())
+    {
+        m_scissors.push_back(rect);
+    }
+    update_clip();
+}
+
+void TextBatch::reset_scissor()
+{
+    m_scissor = TEXT_NO_SCISSOR;
+    update_clip();
+}
+
+void TextBatch::build_draw_list(TextDrawList& out)
+{
+    // Stable, so strings of one atlas are drawn in the order they were added and overlap the same way.
+    std::stable_sort(m_commands.begin(), m_commands.end(), [](const Command& a, const Command& b) { return a.sortKey < b.sortKey; });
+
+    // The instances are handed over as they are, the backend gathers them by draw while uploading. The batch keeps the
+    // list's old storage.
+    out.clear();
+    std::swap(out.instances, m_instances);
+    out.atlases = m_fonts;
+    out.scissors = m_scissors;
+    std::uint32_t instance = 0;
+    for (std::size_t i = 0; i < m_commands.size(); ++i)
+    {
+        const auto& command = m_commands[i];
+        if (i == 0 || command.sortKey != m_commands[i - 1].sortKey)
+        {
+            const auto atlas = std::uint32_t(command.sortKey >> 32) & 0xFFFFFFu;
+            const auto scissor = std::uint32_t(command.sortKey) - 1;
+            out.draws.push_back({ atlas, scissor, std::uint32_t(out.ranges.size()), 0, instance, 0 });
+        }
+
+        // Commands that were already in order continue the previous range.
+        auto& draw = out.draws.back();
+        if (draw.rangeCount > 0 && out.ranges.back().first + out.ranges.back().count == command.firstInstance)
+        {
+            out.ranges.back().count += command.instanceCount;
+        }
+        else
+        {
+            out.ranges.push_back({ command.firstInstance, command.instanceCount });
+            ++draw.rangeCount;
+        }
+        draw.instanceCount += command.instanceCount;
+        instance += command.instanceCount;
+    }
+
+    clear();
+}
+
+void TextBatch::clear()
+{
+    m_instances.clear();
+    m_commands.clear();
+    m_fonts.clear();
+    m_scissors.clear();
+    m_scissor = TEXT_NO_SCISSOR;
+    update_clip();
+}
+
+void TextBatch::add_command(Font& font, std::uint32_t firstInstance)
+{
+    const auto instanceCount = std::uint32_t(m_instances.size()) - firstInstance;
+    if (instanceCount == 0)
+    {
+        return;
+    }
+
+    // Fonts with the same atlas type share a shader, so it goes in the highest byte. No scissor is 0, sorting first.
+    const auto shader = std::uint64_t(font.get_texture_channels());
+    const auto sortKey = (shader << 56) | (std::uint64_t(get_font_slot(font)) << 32) | std::uint32_t(m_scissor + 1);
+
+    // Consecutive strings with the same key grow one command.
+    if (!m_commands.empty())
+    {
+        auto& last = m_commands.back();
+        if (last.sortKey == sortKey && last.firstInstance + last.instanceCount == firstInstance)
+        {
+            last.instanceCount += instanceCount;
+            return;
+        }
+    }
+    m_commands.push_back({ sortKey, firstInstance, instanceCount });
+}
+
+auto TextBatch::get_font_slot(Font& font) -> std::uint32_t
+{
+    // A frame uses a handful of fonts, a linear search beats hashing.
+    const auto it = std::find(m_fonts.begin(), m_fonts.end(), &font);
+    if (it != m_fonts.end())
+    {
+        return std::uint32_t(it - m_fonts.begin());
+    }
+
+    m_fonts.push_back(&font);
+    return std::uint32_t(m_fonts.size() - 1);
+}
+
+void TextBatch::update_clip()
+{
+    m_clip = m_viewport;
+    if (m_scissor != TEXT_NO_SCISSOR)
+    {
+        const auto& rect = m_scissors[m_scissor];
+        m_clip.left = std::max(m_clip.left, rect.x);
+        m_clip.top = std::max(m_clip.top, rect.y);
+        m_clip.right = std::min(m_clip.right, rect.x + rect.width);
+        m_clip.bottom = std::min(m_clip.bottom, rect.y + rect.height);
+    }
+}
@@ -0,0 +1,90 @@
+#include "text_document.hpp"
+#include "font.hpp"
+#include "text_batch.hpp"
+
+#include <algorithm>
+
+TextDocument::TextDocument(Font& font, float fontSize)
+    : m_font(&font),
+      m_fontSize(fontSize),
+      m_defaultLineHeight(font.get_font_info().LineSpacing * font.get_font_scale(fontSize))
+{
+}
+
+void TextDocument::append_line(std::string_view text)
+{
+    const auto width = m_font->measure_line(text) * m_font->get_font_scale(m_fontSize);
+    m_lines.emplace_back(text);
+    m_lineWidths.push_back(width);
+    m_lineHeights.push_back(m_defaultLineHeight);
+    m_heights.push_back(m_defaultLineHeight);
+    m_width = std::max(m_width, width);
+}
+
+void TextDocument::set_line(std::size_t index, std::string_view text)
+{
+    const auto oldWidth = m_lineWidths[index];
+    m_lines[index] = text;
+    m_lineWidths[index] = m_font->measure_line(text) * m_font->get_font_scale(m_fontSize);
+    if (m_lineWidths[index] >= m_width)
+    {
+        m_width = m_lineWidths[index];
+    }
+    else if (oldWidth == m_width)
+    {
+        // The widest line got narrower, another one may be the widest now.
+        update_width();
+    }
+}
+
+void TextDocument::set_line_height(std::size_t index, float height)
+{
+    m_heights.add(index, double(height) - double(m_lineHeights[index]));
+    m_lineHeights[index] = height;
+}
+
+void TextDocument::clear()
+{
+    m_lines.clear();
+    m_lineWidths.clear();
+    m_lineHeights.clear();
+    m_heights.clear();
+    m_width = 0.0f;
+}
+
+auto TextDocument::find_line(float y) const -> std::size_t
+{
+    // The lines ending at or above y are the ones before the line at y.
+    if (m_lines.empty() || y < 0.0f)
+    {
+        return 0;
+    }
+    return std::min(m_heights.find(double(y)), m_lines.size() - 1);
+}
+
+auto TextDocument::draw(TextBatch& batch, float x, float y, float scrollY, float viewHeight, std::uint32_t color) const -> std::size_t
+{
+    if (m_lines.empty())
+    {
+        return 0;
+    }
+
+    const auto viewBottom = scrollY + viewHeight;
+    const auto first = find_line(scrollY);
+    auto top = get_line_top(first);
+    auto line = first;
+    for (; line < m_lines.size() && top < viewBottom; ++line)
+    {
+        if (!m_lines[line].empty())
+        {
+            batch.add_text(*m_font, x, y + top - scrollY, m_lines[line], m_fontSize, color);
+        }
+        top += m_lineHeights[line];
+    }
+    return line - first;
+}
+
+void TextDocument::update_width()
+{
+    m_width = m_lineWidths.empty() ? 0.0f : *std::max_element(m_lineWidths.begin(), m_lineWidths.end());
+}
@@ -0,0 +1,153 @@
+#include "text_instances.hpp"
+#include "font.hpp"
+#include "utf8_reader.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/* Converts a value in [0, 1] to an unsigned normalized integer with `max` as 1. */
+static auto ToUnorm(float value, float max) -> std::uint32_t
+{
+    return std::uint32_t(std::clamp(value, 0.0f, 1.0f) * max + 0.5f);
+}
+
+static auto ToPixel(float value) -> std::int16_t
+{
+    constexpr auto min = float(std::numeric_limits<std::int16_t>::min());
+    constexpr auto max = float(std::numeric_limits<std::int16_t>::max());
+    return std::int16_t(std::clamp(value, min, max));
+}
+
+/* Interpolates between two normalized texture coordinates. */
+static auto LerpUnorm(std::uint16_t a, std::uint16_t b, float t) -> std::uint16_t
+{
+    return std::uint16_t(std::lround(float(a) + (float(b) - float(a)) * t));
+}
+
+auto pack_color(float r, float g, float b, float a) -> std::uint32_t
+{
+    return ToUnorm(r, 255.0f) | (ToUnorm(g, 255.0f) << 8) | (ToUnorm(b, 255.0f) << 16) | (ToUnorm(a, 255.0f) << 24);
+}
+
+auto write_text_instances(GlyphInstance* out, Font& font, float x, float y, std::string_view text, float fontSize, std::uint32_t color,
+                          const TextClipRect* clip) -> std::size_t
+{
+    std::size_t count = 0;
+
+    // Glyphs stay within the font size from the top of the line, but for accents & the distance field padding.
+    const auto slack = fontSize * 0.5f;
+    if (clip && (y + fontSize + slack <= float(clip->top) || y - slack >= float(clip->bottom)))
+    {
+        return 0;
+    }
+
+    float fsScale = font.get_font_scale(fontSize);
+    y += font.get_font_info().Ascender * fsScale;
+
+    // Kerning is applied when the next glyph is placed. The previous glyph is copied, requesting a glyph may move it.
+    GlyphInfo previous{};
+    bool hasPrevious = false;
+    Utf8Reader reader(text);
+    std::uint32_t codepoint{};
+    while (reader.next(codepoint))
+    {
+        // Tabs are as wide as a space, the font has no glyph for control characters.
+        const auto* glyph = font.request_glyph_info(codepoint == '\t' ? ' ' : codepoint);
+        if (!glyph)
+        {
+            glyph = font.request_glyph_info('?');
+        }
+
+        if (hasPrevious)
+        {
+            x += fsScale * (previous.AdvanceX + font.get_kerning(previous, *glyph));
+        }
+        previous = *glyph;
+        hasPrevious = true;
+
+        // The line runs left to right, once a glyph starts past the right edge the ones after it do too.
+        if (clip && x - slack >= float(clip->right))
+        {
+            break;
+        }
+
+        // Glyphs still being generated in the background are left out but keep their advance.
+        if (font.is_glyph_ready(*glyph))
+        {
+            // Corners are snapped to whole pixels, (X0, Y0) is the bottom left one as y points down.
+            const auto& quad = glyph->Quad;
+            const auto left = std::floor(x + quad.X0 * fsScale);
+            const auto bottom = std::floor(y + quad.Y0 * fsScale);
+            const auto right = std::floor(x + quad.X1 * fsScale);
+            const auto top = std::floor(y + quad.Y1 * fsScale);
+            if (right > left && bottom > top)
+            {
+                auto& instance = out[count];
+                instance.x = ToPixel(left);
+                instance.y = ToPixel(top);
+                instance.width = std::uint16_t(std::min(right - left, 65535.0f));
+                instance.height = std::uint16_t(std::min(bottom - top, 65535.0f));
+                instance.u0 = std::uint16_t(ToUnorm(quad.U0, 65535.0f));
+                instance.v0 = std::uint16_t(ToUnorm(quad.V0, 65535.0f));
+                instance.u1 = std::uint16_t(ToUnorm(quad.U1, 65535.0f));
+                instance.v1 = std::uint16_t(ToUnorm(quad.V1, 65535.0f));
+                instance.color = color;
+                if (!clip || clip_glyph_instance(instance, *clip))
+                {
+                    ++count;
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+auto append_text_instances(std::vector<GlyphInstance>& instances, Font& font, float x, float y, std::string_view text, float fontSize,
+                           std::uint32_t color, const TextClipRect* clip) -> std::size_t
+{
+    const auto firstInstance = instances.size();
+    instances.resize(firstInstance + text.size());
+    const auto count = write_text_instances(instances.data() + firstInstance, font, x, y, text, fontSize, color, clip);
+    instances.resize(firstInstance + count);
+    return count;
+}
+
+auto clip_glyph_instance(GlyphInstance& instance, const TextClipRect& clip) -> bool
+{
+    const auto left = std::int32_t(instance.x);
+    const auto top = std::int32_t(instance.y);
+    const auto right = left + std::int32_t(instance.width);
+    const auto bottom = top + std::int32_t(instance.height);
+    const auto clippedLeft = std::max(left, clip.left);
+    const auto clippedTop = std::max(top, clip.top);
+    const auto clippedRight = std::min(right, clip.right);
+    const auto clippedBottom = std::min(bottom, clip.bottom);
+    if (clippedLeft >= clippedRight || clippedTop >= clippedBottom)
+    {
+        return false;
+    }
+    if (clippedLeft == left && clippedTop == top && clippedRight == right && clippedBottom == bottom)
+    {
+        return true;
+    }
+
+    // Texture coordinates are interpolated linearly across the quad, so they are cut at the same fractions as its
+    // edges. The top edge samples v1, see GlyphInstance.
+    const auto width = float(instance.width);
+    const auto height = float(instance.height);
+    const auto u0 = instance.u0;
+    const auto v0 = instance.v0;
+    const auto u1 = instance.u1;
+    const auto v1 = instance.v1;
+    instance.u0 = LerpUnorm(u0, u1, float(clippedLeft - left) / width);
+    instance.u1 = LerpUnorm(u0, u1, float(clippedRight - left) / width);
+    instance.v1 = LerpUnorm(v1, v0, float(clippedTop - top) / height);
+    instance.v0 = LerpUnorm(v1, v0, float(clippedBottom - top) / height);
+    instance.x = std::int16_t(clippedLeft);
+    instance.y = std::int16_t(clippedTop);
+    instance.width = std::uint16_t(clippedRight - clippedLeft);
+    instance.height = std::uint16_t(clippedBottom - clippedTop);
+    return true;
+}
@@ -0,0 +1,159 @@
+#include "text_object.hpp"
+#include "text_render_backend.hpp"
+#include "font.hpp"
+
+#include <cmath>
+#include <utility>
+
+TextObject::TextObject(Font& font, std::string_view text, float fontSize, std::uint32_t color, float x, float y)
+    : m_font(&font),
+      m_text(text),
+      m_fontSize(fontSize),
+      m_color(color),
+      m_x(x),
+      m_y(y)
+{
+}
+
+TextObject::~TextObject()
+{
+    release();
+}
+
+TextObject::TextObject(TextObject&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+auto TextObject::operator=(TextObject&& other) noexcept -> TextObject&
+{
+    if (this != &other)
+    {
+        release();
+        m_font = other.m_font;
+        m_text = std::move(other.m_text);
+        m_fontSize = other.m_fontSize;
+        m_color = other.m_color;
+        m_x = other.m_x;
+        m_y = other.m_y;
+        m_instances = std::move(other.m_instances);
+        m_dirty = other.m_dirty;
+        m_layoutX = other.m_layoutX;
+        m_layoutY = other.m_layoutY;
+        m_layoutTextureVersion = other.m_layoutTextureVersion;
+        m_version = other.m_version;
+        m_allocation = std::exchange(other.m_allocation, {});
+    }
+    return *this;
+}
+
+void TextObject::set_font(Font& font)
+{
+    if (m_font != &font)
+    {
+        m_font = &font;
+        m_dirty |= DIRTY_LAYOUT;
+    }
+}
+
+void TextObject::set_text(std::string_view text)
+{
+    if (m_text != text)
+    {
+        m_text = text;
+        m_dirty |= DIRTY_LAYOUT;
+    }
+}
+
+void TextObject::set_font_size(float fontSize)
+{
+    if (m_fontSize != fontSize)
+    {
+        m_fontSize = fontSize;
+        m_dirty |= DIRTY_LAYOUT;
+    }
+}
+
+void TextObject::set_color(std::uint32_t color)
+{
+    if (m_color != color)
+    {
+        m_color = color;
+        m_dirty |= DIRTY_COLOR;
+    }
+}
+
+void TextObject::set_position(float x, float y)
+{
+    m_x = x;
+    m_y = y;
+}
+
+auto TextObject::update() -> bool
+{
+    if (!m_font)
+    {
+        return false;
+    }
+
+    // Pending glyphs were left out & a rearranged atlas moves glyphs, either way the layout is stale.
+    if (m_font->get_texture_version() != m_layoutTextureVersion)
+    {
+        m_dirty |= DIRTY_LAYOUT;
+    }
+
+    // Glyph corners are snapped to whole pixels, so a move by whole pixels moves every corner by as much.
+    const auto dx = m_x - m_layoutX;
+    const auto dy = m_y - m_layoutY;
+    const bool moved = dx != 0.0f || dy != 0.0f;
+    if (moved && !(m_dirty & DIRTY_LAYOUT))
+    {
+        if (dx == std::floor(dx) && dy == std::floor(dy))
+        {
+            for (auto& instance : m_instances)
+            {
+                instance.x = std::int16_t(instance.x + std::int32_t(dx));
+                instance.y = std::int16_t(instance.y + std::int32_t(dy));
+            }
+            m_layoutX = m_x;
+            m_layoutY = m_y;
+        }
+        else
+        {
+            m_dirty |= DIRTY_LAYOUT;
+        }
+    }
+    else if (!moved && !m_dirty)
+    {
+        return false;
+    }
+
+    if (m_dirty & DIRTY_LAYOUT)
+    {
+        m_layoutTextureVersion = m_font->get_texture_version();
+        m_instances.clear();
+        append_text_instances(m_instances, *m_font, m_x, m_y, m_text, m_fontSize, m_color);
+        m_layoutX = m_x;
+        m_layoutY = m_y;
+    }
+    else if (m_dirty & DIRTY_COLOR)
+    {
+        for (auto& instance : m_instances)
+        {
+            instance.color = m_color;
+        }
+    }
+
+    m_dirty = 0;
+    ++m_version;
+    return true;
+}
+
+void TextObject::release()
+{
+    if (m_allocation.backend)
+    {
+        m_allocation.backend->release(*this);
+        m_allocation = {};
+    }
+}
@@ -0,0 +1,88 @@
+#include "text_render_backend.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+RecordingTextBackend::RecordingTextBackend(bool keepDrawLists)
+    : m_keepDrawLists(keepDrawLists)
+{
+}
+
+void RecordingTextBackend::begin_frame()
+{
+}
+
+void RecordingTextBackend::render(const TextDrawList& drawList, std::uint32_t viewportWidth, std::uint32_t viewportHeight)
+{
+    m_drawCount += drawList.draws.size();
+    m_instanceCount += drawList.instances.size();
+    if (m_keepDrawLists)
+    {
+        m_recordings.push_back({ m_frame, viewportWidth, viewportHeight, drawList });
+    }
+}
+
+void RecordingTextBackend::render(std::span<TextObject* const> objects, std::uint32_t viewportWidth, std::uint32_t viewportHeight)
+{
+    m_objectDrawList.clear();
+    for (auto* object : objects)
+    {
+        object->update();
+
+        auto& allocation = object->get_allocation();
+        if (allocation.backend && allocation.backend != this)
+        {
+            throw std::runtime_error("A text object can only be drawn by one backend.");
+        }
+        allocation.backend = this;
+        if (allocation.version != object->get_version())
+        {
+            allocation.version = object->get_version();
+            ++m_uploadCount;
+        }
+
+        const auto instances = object->get_instances();
+        if (instances.empty())
+        {
+            continue;
+        }
+
+        auto& atlases = m_objectDrawList.atlases;
+        auto atlas = std::find(atlases.begin(), atlases.end(), object->get_font());
+        if (atlas == atlases.end())
+        {
+            atlas = atlases.insert(atlases.end(), object->get_font());
+        }
+
+        TextDraw draw{};
+        draw.atlas = std::uint32_t(atlas - atlases.begin());
+        draw.firstRange = std::uint32_t(m_objectDrawList.ranges.size());
+        draw.rangeCount = 1;
+        draw.firstInstance = std::uint32_t(m_objectDrawList.instances.size());
+        draw.instanceCount = std::uint32_t(instances.size());
+        m_objectDrawList.draws.push_back(draw);
+        m_objectDrawList.ranges.push_back({ draw.firstInstance, draw.instanceCount });
+        m_objectDrawList.instances.insert(m_objectDrawList.instances.end(), instances.begin(), instances.end());
+    }
+
+    render(m_objectDrawList, viewportWidth, viewportHeight);
+}
+
+void RecordingTextBackend::end_frame()
+{
+    ++m_frame;
+}
+
+void RecordingTextBackend::release(TextObject& object)
+{
+    object.get_allocation() = {};
+}
+
+void RecordingTextBackend::clear()
+{
+    m_recordings.clear();
+    m_frame = 0;
+    m_drawCount = 0;
+    m_instanceCount = 0;
+    m_uploadCount = 0;
+}
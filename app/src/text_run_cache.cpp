@@ -0,0 +1,100 @@
+#include "text_run_cache.hpp"
+#include "font.hpp"
+
+#include <bit>
+#include <cstring>
+#include <iterator>
+
+/* Hashes 8 bytes per step, strings are hashed on every lookup. */
+static auto HashRun(const Font& font, std::string_view text, float fontSize) -> std::uint64_t
+{
+    constexpr std::uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ull;
+    const auto mix = [](std::uint64_t hash, std::uint64_t value)
+    {
+        hash = (hash ^ value) * MULTIPLIER;
+        return hash ^ (hash >> 32);
+    };
+
+    auto hash = mix(font.get_id(), std::bit_cast<std::uint32_t>(fontSize));
+    hash = mix(hash, text.size());
+
+    std::size_t i = 0;
+    for (; i + 8 <= text.size(); i += 8)
+    {
+        std::uint64_t word{};
+        std::memcpy(&word, text.data() + i, 8);
+        hash = mix(hash, word);
+    }
+    if (i < text.size())
+    {
+        std::uint64_t word{};
+        std::memcpy(&word, text.data() + i, text.size() - i);
+        hash = mix(hash, word);
+    }
+    return hash;
+}
+
+TextRunCache::TextRunCache(std::size_t maxBytes)
+    : m_maxBytes(maxBytes)
+{
+}
+
+auto TextRunCache::get(Font& font, std::string_view text, float fontSize) -> std::span<const GlyphInstance>
+{
+    const auto hash = HashRun(font, text, fontSize);
+    if (const auto it = m_lookup.find(hash); it != m_lookup.end())
+    {
+        auto entry = it->second;
+        if (entry->fontId == font.get_id() && entry->fontSize == fontSize && entry->text == text
+            && entry->textureVersion == font.get_texture_version())
+        {
+            ++m_hits;
+            m_entries.splice(m_entries.begin(), m_entries, entry);
+            return entry->instances;
+        }
+
+        // A hash collision or a stale run, either way it is replaced.
+        evict(entry);
+    }
+
+    ++m_misses;
+    auto& entry = m_entries.emplace_front();
+    entry.hash = hash;
+    entry.fontId = font.get_id();
+    entry.fontSize = fontSize;
+    entry.textureVersion = font.get_texture_version();
+    entry.text = text;
+    append_text_instances(entry.instances, font, 0.0f, 0.0f, text, fontSize, 0);
+    entry.instances.shrink_to_fit();
+    m_lookup.emplace(hash, m_entries.begin());
+    m_usedBytes += GetEntryBytes(entry);
+
+    // The new entry is at the front, so it survives even if it is over budget on its own.
+    while (m_usedBytes > m_maxBytes && m_entries.size() > 1)
+    {
+        evict(std::prev(m_entries.end()));
+    }
+
+    return m_entries.front().instances;
+}
+
+void TextRunCache::clear()
+{
+    m_entries.clear();
+    m_lookup.clear();
+    m_usedBytes = 0;
+    m_hits = 0;
+    m_misses = 0;
+}
+
+auto TextRunCache::GetEntryBytes(const Entry& entry) -> std::size_t
+{
+    return sizeof(Entry) + entry.text.capacity() + entry.instances.capacity() * sizeof(GlyphInstance);
+}
+
+void TextRunCache::evict(std::list<Entry>::iterator entry)
+{
+    m_usedBytes -= GetEntryBytes(*entry);
+    m_lookup.erase(entry->hash);
+    m_entries.erase(entry);
+}
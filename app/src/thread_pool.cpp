@@ -0,0 +1,124 @@
+#include "thread_pool.hpp"
+
+/* Set on the pool's own workers, so tasks they submit stay on their queue. */
+static thread_local const ThreadPool* t_workerPool = nullptr;
+static thread_local std::uint32_t t_workerIndex = 0;
+
+ThreadPool::ThreadPool(std::uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    m_queues.reserve(threadCount);
+    for (std::uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+
+    m_workers.reserve(threadCount);
+    for (std::uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_workers.emplace_back(&ThreadPool::worker_main, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wakeCondition.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+auto ThreadPool::get_shared() -> ThreadPool&
+{
+    static ThreadPool pool{};
+    return pool;
+}
+
+auto ThreadPool::get_thread_count() const -> std::uint32_t
+{
+    return std::uint32_t(m_workers.size());
+}
+
+auto ThreadPool::get_max_concurrency() const -> std::uint32_t
+{
+    return get_thread_count() + 1;
+}
+
+void ThreadPool::push(Task task)
+{
+    const auto queue = t_workerPool == this ? t_workerIndex
+                                            : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % std::uint32_t(m_queues.size());
+    {
+        std::lock_guard lock(m_queues[queue]->mutex);
+        m_queues[queue]->tasks.push_back(std::move(task));
+    }
+
+    m_pendingTasks.fetch_add(1, std::memory_order_release);
+    {
+        // Pairs with the predicate check in worker_main, so a worker about to sleep can't miss the task.
+        std::lock_guard lock(m_sleepMutex);
+    }
+    m_wakeCondition.notify_one();
+}
+
+auto ThreadPool::pop(std::uint32_t worker, Task& outTask) -> bool
+{
+    const auto queueCount = std::uint32_t(m_queues.size());
+    for (std::uint32_t i = 0; i < queueCount; ++i)
+    {
+        auto& queue = *m_queues[(worker + i) % queueCount];
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty())
+        {
+            continue;
+        }
+
+        // Own queue is worked front to back, others are stolen from the back.
+        if (i == 0)
+        {
+            outTask = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        else
+        {
+            outTask = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        m_pendingTasks.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::worker_main(std::uint32_t worker)
+{
+    t_workerPool = this;
+    t_workerIndex = worker;
+
+    while (true)
+    {
+        Task task{};
+        if (pop(worker, task))
+        {
+            task();
+            continue;
+        }
+
+        std::unique_lock lock(m_sleepMutex);
+        m_wakeCondition.wait(lock, [this] { return m_stopping || m_pendingTasks.load(std::memory_order_acquire) != 0; });
+        if (m_stopping && m_pendingTasks.load(std::memory_order_acquire) == 0)
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#include "utf8_reader.hpp"
+
+#include <bit>
+#include <cstring>
+
+// UTF8_READER_SCALAR leaves out the SSE2 path, so the portable one can be tested on any machine.
+#if !defined(UTF8_READER_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define UTF8_READER_SSE2
+#include <emmintrin.h>
+#endif
+
+auto find_ascii_end(std::string_view text, std::size_t index) -> std::size_t
+{
+    const auto* bytes = text.data();
+    const auto size = text.size();
+
+#ifdef UTF8_READER_SSE2
+    // The top bit of every byte of the block, any set bit is a non-ASCII byte.
+    for (; index + 16 <= size; index += 16)
+    {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + index));
+        if (const auto mask = std::uint32_t(_mm_movemask_epi8(block)))
+        {
+            return index + std::size_t(std::countr_zero(mask));
+        }
+    }
+#endif
+
+    for (; index + 8 <= size; index += 8)
+    {
+        std::uint64_t block{};
+        std::memcpy(&block, bytes + index, 8);
+        if (block & 0x8080808080808080ull)
+        {
+            break;  // Found by the loop below.
+        }
+    }
+
+    while (index < size && std::uint8_t(bytes[index]) < 0x80)
+    {
+        ++index;
+    }
+    return index;
+}
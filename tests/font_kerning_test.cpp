@@ -0,0 +1,219 @@
+#include "font_kerning.hpp"
+#include "mapped_file.hpp"
+#include "test.hpp"
+
+#include <msdf-atlas-gen.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+/* The whole font file, copied so tests can damage it. */
+static auto LoadFontFile(const char* filename) -> std::vector<std::uint8_t>
+{
+    MappedFile file{};
+    CHECK(file.open(std::filesystem::path(TEST_FONT_DIRECTORY) / filename));
+    return { file.bytes().begin(), file.bytes().end() };
+}
+
+/* Returns the byte offset of the table record tagged `tag` in the table directory, or 0. */
+static auto FindTableRecord(const std::vector<std::uint8_t>& fontData, const char* tag) -> std::size_t
+{
+    const std::size_t tableCount = (fontData[4] << 8) | fontData[5];
+    for (std::size_t i = 0; i < tableCount; ++i)
+    {
+        const auto record = 12 + i * 16;
+        if (std::equal(tag, tag + 4, fontData.begin() + record))
+        {
+            return record;
+        }
+    }
+    return 0;
+}
+
+static auto ReadU32(const std::vector<std::uint8_t>& data, std::size_t offset) -> std::uint32_t
+{
+    return (std::uint32_t(data[offset]) << 24) | (data[offset + 1] << 16) | (data[offset + 2] << 8) | data[offset + 3];
+}
+
+/* The kerning of the printable ASCII glyphs as FontGeometry::loadKerning reports it through FreeType. */
+struct FreetypeKerning
+{
+    std::vector<std::int32_t> glyphIndices{};  // Sorted & deduplicated.
+    std::map<std::pair<int, int>, double> pairs{};
+    std::map<char, std::int32_t> asciiGlyphs{};
+};
+
+static auto LoadFreetypeKerning(const std::vector<std::uint8_t>& fontData, double fontScale) -> FreetypeKerning
+{
+    std::unique_ptr<msdfgen::FreetypeHandle, decltype(&msdfgen::deinitializeFreetype)> freetype{ msdfgen::initializeFreetype(),
+                                                                                                 &msdfgen::deinitializeFreetype };
+    std::unique_ptr<msdfgen::FontHandle, decltype(&msdfgen::destroyFont)> font{
+        msdfgen::loadFontData(freetype.get(), fontData.data(), std::int32_t(fontData.size())), &msdfgen::destroyFont
+    };
+    CHECK(font != nullptr);
+
+    FreetypeKerning kerning{};
+    std::vector<msdf_atlas::GlyphGeometry> glyphs{};
+    msdf_atlas::FontGeometry geometry(&glyphs);
+    geometry.loadCharset(font.get(), fontScale, msdf_atlas::Charset::ASCII, false, true);
+    for (const auto& glyph : glyphs)
+    {
+        kerning.glyphIndices.push_back(glyph.getIndex());
+        kerning.asciiGlyphs[char(glyph.getCodepoint())] = glyph.getIndex();
+    }
+    std::sort(kerning.glyphIndices.begin(), kerning.glyphIndices.end());
+    kerning.glyphIndices.erase(std::unique(kerning.glyphIndices.begin(), kerning.glyphIndices.end()), kerning.glyphIndices.end());
+    kerning.pairs = geometry.getKerning();
+    return kerning;
+}
+
+/* Returns the kerning of `first` followed by `second` in `pairs`, zero if they have none. */
+static auto FindKerning(const std::vector<KerningPair>& pairs, std::int32_t first, std::int32_t second) -> double
+{
+    auto it = std::lower_bound(pairs.begin(),
+                               pairs.end(),
+                               std::pair(first, second),
+                               [](const KerningPair& pair, const std::pair<std::int32_t, std::int32_t>& key)
+                               { return std::pair(pair.first, pair.second) < key; });
+    return it != pairs.end() && it->first == first && it->second == second ? it->advance : 0.0;
+}
+
+/* Pairs are sorted, unique, nonzero & between loaded glyphs, whatever the tables contain. */
+static void CheckWellFormed(const std::vector<KerningPair>& pairs, const std::vector<std::int32_t>& glyphIndices)
+{
+    for (std::size_t i = 0; i < pairs.size(); ++i)
+    {
+        CHECK(pairs[i].advance != 0.0);
+        CHECK(std::binary_search(glyphIndices.begin(), glyphIndices.end(), pairs[i].first));
+        CHECK(std::binary_search(glyphIndices.begin(), glyphIndices.end(), pairs[i].second));
+        if (i > 0)
+        {
+            CHECK(std::pair(pairs[i - 1].first, pairs[i - 1].second) < std::pair(pairs[i].first, pairs[i].second));
+        }
+    }
+}
+
+static void CheckMatchesFreetype(const std::vector<std::uint8_t>& fontData)
+{
+    const auto expected = LoadFreetypeKerning(fontData, 2.0);
+    const auto pairs = load_font_kerning(fontData, expected.glyphIndices, 2.0);
+    CheckWellFormed(pairs, expected.glyphIndices);
+    CHECK(pairs.size() == expected.pairs.size());
+    for (const auto& [key, advance] : expected.pairs)
+    {
+        CHECK(std::abs(FindKerning(pairs, key.first, key.second) - advance) < 1e-9);
+    }
+}
+
+TEST_CASE(matches_freetype_on_fonts_without_gpos_kerning)
+{
+    // Open Sans has neither a GPOS `kern` feature nor a `kern` table, so neither loader finds any pairs.
+    for (const char* filename : { "OpenSans-Regular.ttf", "OpenSans-Bold.ttf", "OpenSans-Italic.ttf" })
+    {
+        CheckMatchesFreetype(LoadFontFile(filename));
+    }
+
+    // FreeType only reads the `kern` table, so hide the GPOS table of a font that has both.
+    auto fontData = LoadFontFile("segoesc.ttf");
+    const auto gposRecord = FindTableRecord(fontData, "GPOS");
+    CHECK(gposRecord != 0);
+    CHECK(FindTableRecord(fontData, "kern") != 0);
+    fontData[gposRecord] = 'X';
+    CheckMatchesFreetype(fontData);
+}
+
+TEST_CASE(prefers_gpos_pair_adjustments)
+{
+    const auto fontData = LoadFontFile("segoesc.ttf");
+    const auto freetype = LoadFreetypeKerning(fontData, 1.0);
+    const auto pairs = load_font_kerning(fontData, freetype.glyphIndices, 2.0);
+    CheckWellFormed(pairs, freetype.glyphIndices);
+
+    // In font units of a 2048 unit em, through class based (format 2) subtables. The `kern` table has none of these.
+    const struct
+    {
+        const char* pair;
+        double units;
+    } expected[] = { { "AV", -61.0 }, { "VA", -307.0 }, { "LT", -164.0 }, { "Av", -82.0 }, { "To", 0.0 }, { "AA", 0.0 } };
+    for (const auto& [pair, units] : expected)
+    {
+        const auto first = freetype.asciiGlyphs.at(pair[0]);
+        const auto second = freetype.asciiGlyphs.at(pair[1]);
+        CHECK(std::abs(FindKerning(pairs, first, second) - units * 2.0 / 2048.0) < 1e-9);
+        CHECK(!freetype.pairs.contains({ first, second }));
+    }
+
+    // Only the loaded glyphs are kerned, with the same adjustments.
+    std::vector<std::int32_t> glyphIndices = { freetype.asciiGlyphs.at('A'), freetype.asciiGlyphs.at('V') };
+    std::sort(glyphIndices.begin(), glyphIndices.end());
+    const auto few = load_font_kerning(fontData, glyphIndices, 2.0);
+    CheckWellFormed(few, glyphIndices);
+    CHECK(!few.empty());
+    for (const auto& pair : few)
+    {
+        CHECK(FindKerning(pairs, pair.first, pair.second) == pair.advance);
+    }
+}
+
+TEST_CASE(ignores_truncated_and_corrupt_tables)
+{
+    const auto fontData = LoadFontFile("segoesc.ttf");
+    const auto glyphIndices = LoadFreetypeKerning(fontData, 1.0).glyphIndices;
+    CHECK(load_font_kerning(fontData, {}, 1.0).empty());
+    CHECK(load_font_kerning({}, glyphIndices, 1.0).empty());
+
+    // Cut short files lose the tables past their end.
+    for (std::size_t size = 0; size < fontData.size(); size += fontData.size() / 61 + 1)
+    {
+        const std::vector<std::uint8_t> truncated(fontData.begin(), fontData.begin() + std::ptrdiff_t(size));
+        CheckWellFormed(load_font_kerning(truncated, glyphIndices, 1.0), glyphIndices);
+    }
+
+    std::mt19937 random(11);
+    for (bool hideGpos : { false, true })
+    {
+        // Damages the GPOS table, or the `kern` table with GPOS hidden.
+        auto damaged = fontData;
+        if (hideGpos)
+        {
+            damaged[FindTableRecord(damaged, "GPOS")] = 'X';
+        }
+        const auto record = FindTableRecord(damaged, hideGpos ? "kern" : "GPOS");
+        const auto offset = ReadU32(damaged, record + 8);
+        const auto length = ReadU32(damaged, record + 12);
+
+        // A table whose recorded length cuts through its subtables, reads past it must come back as zero.
+        for (std::uint32_t cut = 0; cut < length; cut += length / 37 + 1)
+        {
+            auto cutShort = damaged;
+            cutShort[record + 12] = std::uint8_t(cut >> 24);
+            cutShort[record + 13] = std::uint8_t(cut >> 16);
+            cutShort[record + 14] = std::uint8_t(cut >> 8);
+            cutShort[record + 15] = std::uint8_t(cut);
+            CheckWellFormed(load_font_kerning(cutShort, glyphIndices, 1.0), glyphIndices);
+        }
+
+        // Random bytes of the table overwritten, offsets & counts pointing anywhere included.
+        for (std::int32_t i = 0; i < 200; ++i)
+        {
+            auto corrupt = damaged;
+            for (std::int32_t j = 0; j < 8; ++j)
+            {
+                corrupt[offset + random() % length] = std::uint8_t(random());
+            }
+            CheckWellFormed(load_font_kerning(corrupt, glyphIndices, 1.0), glyphIndices);
+        }
+    }
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,71 @@
+#include "font.hpp"
+#include "test.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+static auto MakeAsyncConfig() -> FontConfig
+{
+    // Uncached, so the atlas is always generated in the background, and with enough glyphs to take a while.
+    FontConfig config{};
+    config.charsetRanges = { { 0x0020, 0x00FF }, { 0x0100, 0x052F } };
+    config.asyncGeneration = true;
+    config.cacheDirectory.clear();
+    return config;
+}
+
+static auto GetFontPath(const char* filename) -> std::filesystem::path
+{
+    return std::filesystem::path(TEST_FONT_DIRECTORY) / filename;
+}
+
+/* Polls until the atlas is complete, returns false if it takes unreasonably long. */
+static auto WaitForAtlas(const Font& font) -> bool
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::minutes(2);
+    while (!font.is_atlas_complete())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+TEST_CASE(move_assigns_while_generating_in_the_background)
+{
+    // Both atlases are still being generated, the target's generator must stop before its data is freed. Run under a
+    // sanitizer to catch it writing into freed data.
+    Font target(GetFontPath("OpenSans-Bold.ttf"), MakeAsyncConfig());
+    Font source(GetFontPath("OpenSans-Regular.ttf"), MakeAsyncConfig());
+    target = std::move(source);
+
+    // The moved generator keeps filling the data it now shares with the target.
+    CHECK(WaitForAtlas(target));
+    const auto* glyph = target.get_glyph('A');
+    CHECK(glyph != nullptr);
+    if (glyph)
+    {
+        CHECK(target.is_glyph_ready(*glyph));
+    }
+    CHECK(target.get_texture_data() != nullptr);
+}
+
+TEST_CASE(move_assigns_over_a_finished_font)
+{
+    Font target(GetFontPath("OpenSans-Bold.ttf"), MakeAsyncConfig());
+    CHECK(WaitForAtlas(target));
+
+    Font source(GetFontPath("OpenSans-Regular.ttf"), MakeAsyncConfig());
+    target = std::move(source);
+    CHECK(WaitForAtlas(target));
+    CHECK(target.get_glyph_info('A') != nullptr);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,133 @@
+#include "font.hpp"
+#include "line_advance_index.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+/* Segoe Script kerns pairs like "AV" & "To", so edits change the advance of the character in front of them. */
+static auto GetFont() -> Font&
+{
+    FontConfig config{};
+    config.cacheDirectory.clear();
+    static Font font(std::filesystem::path(TEST_FONT_DIRECTORY) / "segoesc.ttf", config);
+    return font;
+}
+
+static auto Join(const std::vector<std::string>& characters, std::size_t first, std::size_t end) -> std::string
+{
+    std::string text{};
+    for (auto i = first; i < end; ++i)
+    {
+        text += characters[i];
+    }
+    return text;
+}
+
+/* Every caret of both indices is bit for bit the same. */
+static auto Equal(const LineAdvanceIndex& a, const LineAdvanceIndex& b) -> bool
+{
+    if (a.get_character_count() != b.get_character_count() || a.get_width() != b.get_width())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i <= a.get_character_count(); ++i)
+    {
+        if (a.get_caret_x(i) != b.get_caret_x(i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE(edited_index_matches_a_rebuilt_one)
+{
+    const auto& font = GetFont();
+    CHECK(font.get_kerning(*font.get_glyph_info('A'), *font.get_glyph_info('V')) < 0.0f);
+
+    // Kerned pairs, a tab, codepoints of every length, one the atlas lacks.
+    const std::vector<std::string> alphabet = { "A", "V", "T", "o", "a", " ", "\t", ".", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80" };
+    std::vector<std::string> characters{};
+    LineAdvanceIndex edited{};
+    edited.build(font, "");
+
+    std::mt19937 random(22);
+    for (std::int32_t i = 0; i < 3000; ++i)
+    {
+        // Also edits that reach past the end of the line, which are cut to it. Long lines shrink again.
+        const auto first = random() % (characters.size() + 3);
+        const auto removeCount = characters.size() > 80 || random() % 4 == 0 ? random() % 6 : 0;
+        std::vector<std::string> inserted{};
+        for (auto count = random() % 6; count > 0; --count)
+        {
+            inserted.push_back(alphabet[random() % alphabet.size()]);
+        }
+
+        edited.replace(font, first, removeCount, Join(inserted, 0, inserted.size()));
+        const auto clampedFirst = std::min<std::size_t>(first, characters.size());
+        const auto clampedEnd = std::min<std::size_t>(clampedFirst + removeCount, characters.size());
+        characters.erase(characters.begin() + std::ptrdiff_t(clampedFirst), characters.begin() + std::ptrdiff_t(clampedEnd));
+        characters.insert(characters.begin() + std::ptrdiff_t(clampedFirst), inserted.begin(), inserted.end());
+
+        LineAdvanceIndex rebuilt{};
+        rebuilt.build(font, Join(characters, 0, characters.size()));
+        CHECK(edited.get_character_count() == characters.size());
+        CHECK(Equal(edited, rebuilt));
+    }
+
+    // Measured like a whole line, give or take the order of the additions.
+    const auto line = Join(characters, 0, characters.size());
+    CHECK(std::abs(edited.get_width() - font.measure_line(line)) <= edited.get_width() * 1e-5f);
+}
+
+TEST_CASE(hit_test_round_trips_with_carets)
+{
+    const auto& font = GetFont();
+    LineAdvanceIndex index{};
+    index.build(font, "AVAWAY To.\t\xE2\x82\xAC!");
+    const auto count = index.get_character_count();
+    CHECK(count == 13);
+    CHECK(index.get_caret_x(0) == 0.0f);
+    CHECK(index.get_caret_x(count) == index.get_width());
+
+    for (std::size_t i = 0; i <= count; ++i)
+    {
+        CHECK(index.hit_test(index.get_caret_x(i)) == i);
+        if (i < count)
+        {
+            // Either side of the middle of a character picks the caret on that side.
+            const auto left = index.get_caret_x(i);
+            const auto right = index.get_caret_x(i + 1);
+            CHECK(right > left);
+            const auto middle = (left + right) * 0.5f;
+            const auto quarter = (right - left) * 0.25f;
+            CHECK(index.hit_test(middle - quarter) == i);
+            CHECK(index.hit_test(middle + quarter) == i + 1);
+        }
+    }
+
+    // In front of the line & past its end.
+    CHECK(index.hit_test(-0.001f) == 0);
+    CHECK(index.hit_test(-100.0f) == 0);
+    CHECK(index.hit_test(index.get_width() + 0.001f) == count);
+    CHECK(index.hit_test(1000.0f) == count);
+    CHECK(index.get_caret_x(count + 5) == index.get_width());
+
+    LineAdvanceIndex empty{};
+    empty.build(font, "");
+    CHECK(empty.get_character_count() == 0);
+    CHECK(empty.get_width() == 0.0f);
+    CHECK(empty.hit_test(-1.0f) == 0);
+    CHECK(empty.hit_test(1.0f) == 0);
+    CHECK(empty.get_caret_x(3) == 0.0f);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,176 @@
+#include "font.hpp"
+#include "paragraph_layout.hpp"
+#include "test.hpp"
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static auto GetFont() -> Font&
+{
+    FontConfig config{};
+    config.cacheDirectory.clear();
+    static Font font(std::filesystem::path(TEST_FONT_DIRECTORY) / "OpenSans-Regular.ttf", config);
+    return font;
+}
+
+static auto Equal(const std::vector<ParagraphLine>& a, const std::vector<ParagraphLine>& b) -> bool
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i].begin != b[i].begin || a[i].end != b[i].end || a[i].next != b[i].next || a[i].width != b[i].width)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* The lines of a paragraph laid out from scratch. */
+static auto LayOut(std::string_view text, float maxWidth) -> std::vector<ParagraphLine>
+{
+    ParagraphLayout paragraph(GetFont(), 16.0f, maxWidth);
+    paragraph.set_text(text);
+    return paragraph.get_lines();
+}
+
+static auto IsContinuation(const std::string& text, std::size_t offset) -> bool
+{
+    return offset < text.size() && (std::uint8_t(text[offset]) & 0xC0) == 0x80;
+}
+
+/* Returns where `pattern` occurs in `text` from a random offset on, wrapping around, or npos. */
+static auto FindFrom(const std::string& text, std::string_view pattern, std::size_t offset) -> std::size_t
+{
+    const auto found = text.find(pattern, offset);
+    return found != std::string::npos ? found : text.find(pattern);
+}
+
+static constexpr std::string_view SEED_TEXT = "Lorem ipsum dolor  sit amet,\r\nconsectetur   adipiscing\telit. "
+                                               "Supercalifragilisticexpialidocious words break\r\n\r\nanywhere\n"
+                                               "  indented line ending in spaces   \r\nend";
+
+TEST_CASE(edits_match_a_fresh_layout)
+{
+    // Edits land at line starts, within long words, around line breaks & within runs of spaces.
+    const std::string_view insertions[] = { "",  "a", "wide ", " ",     "   ", "\t", "\n", "\r\n", "\r",
+                                            "\xC3\xA9", "Wwwwwwwwwwwwwwwwwwwwwwwwwwwwwww", "Mm mM", "  \r\n  " };
+    std::mt19937 random(23);
+    for (float maxWidth : { 120.0f, 37.0f, 1.0f })
+    {
+        ParagraphLayout paragraph(GetFont(), 16.0f, maxWidth);
+        paragraph.set_text(SEED_TEXT);
+        for (std::int32_t i = 0; i < 1500; ++i)
+        {
+            const auto& text = paragraph.get_text();
+            const auto& lines = paragraph.get_lines();
+            const auto start = random() % (text.size() + 1);
+            std::size_t offset = start;
+            switch (random() % 4)
+            {
+                case 0: offset = lines[random() % lines.size()].begin; break;
+                case 1:
+                {
+                    const auto found = FindFrom(text, "wwwwwwww", start);
+                    const auto word = found != std::string::npos ? found : FindFrom(text, "ilistic", start);
+                    offset = word != std::string::npos ? word + random() % 8 : start;
+                    break;
+                }
+                case 2:
+                {
+                    const auto found = FindFrom(text, "\r\n", start);
+                    offset = found != std::string::npos ? found + random() % 3 : start;
+                    break;
+                }
+                default:
+                {
+                    const auto found = FindFrom(text, "  ", start);
+                    offset = found != std::string::npos ? found + random() % 3 : start;
+                    break;
+                }
+            }
+            offset = std::min(offset, text.size());
+
+            // Neither end of the edit may split a UTF-8 sequence.
+            auto removeEnd = std::min(offset + random() % 5, text.size());
+            while (IsContinuation(text, offset))
+            {
+                --offset;
+            }
+            while (IsContinuation(text, removeEnd))
+            {
+                ++removeEnd;
+            }
+
+            paragraph.replace(offset, removeEnd - offset, insertions[random() % std::size(insertions)]);
+            CHECK(Equal(paragraph.get_lines(), LayOut(paragraph.get_text(), maxWidth)));
+            CHECK(paragraph.get_relaid_line_count() >= 1);
+            CHECK(paragraph.get_relaid_line_count() <= paragraph.get_lines().size());
+
+            if (paragraph.get_text().size() > 600)
+            {
+                paragraph.set_text(SEED_TEXT);
+            }
+        }
+    }
+}
+
+TEST_CASE(edits_within_a_line_lay_out_few_lines)
+{
+    std::string text{};
+    for (std::int32_t i = 0; i < 40; ++i)
+    {
+        text += "the quick brown fox jumps over the lazy dog ";
+    }
+    ParagraphLayout paragraph(GetFont(), 16.0f, 150.0f);
+    paragraph.set_text(text);
+    const auto lines = paragraph.get_lines();
+    CHECK(lines.size() > 40);
+    CHECK(paragraph.get_relaid_line_count() == lines.size());
+
+    // A character replaced by itself lays out the edited line & the one in front of it, which it could have moved to.
+    const auto middle = lines[20].begin + 2;
+    paragraph.replace(middle, 1, text.substr(middle, 1));
+    CHECK(Equal(paragraph.get_lines(), lines));
+    CHECK(paragraph.get_relaid_line_count() == 2);
+
+    paragraph.replace(1, 1, text.substr(1, 1));
+    CHECK(Equal(paragraph.get_lines(), lines));
+    CHECK(paragraph.get_relaid_line_count() == 1);
+
+    // Words inserted into & line breaks removed from lines that end in a line break.
+    std::string hardLines{};
+    for (std::int32_t i = 0; i < 40; ++i)
+    {
+        hardLines += "line " + std::to_string(i) + " of the text\r\n";
+    }
+    paragraph.set_max_width(1000.0f);
+    paragraph.set_text(hardLines);
+    CHECK(paragraph.get_lines().size() == 41);
+    const auto lineBegin = paragraph.get_lines()[20].begin;
+    paragraph.replace(lineBegin + 2, 0, "extraordinarily ");
+    CHECK(Equal(paragraph.get_lines(), LayOut(paragraph.get_text(), 1000.0f)));
+    CHECK(paragraph.get_relaid_line_count() == 2);
+
+    // Joining two lines lays out the joined line & the one in front of it.
+    paragraph.replace(lineBegin - 2, 2, "");
+    CHECK(paragraph.get_lines().size() == 40);
+    CHECK(Equal(paragraph.get_lines(), LayOut(paragraph.get_text(), 1000.0f)));
+    CHECK(paragraph.get_relaid_line_count() == 2);
+
+    // A line break appended to the text lays out the two lines in front of it & the empty line it adds.
+    paragraph.replace(paragraph.get_text().size(), 0, "\r\n");
+    CHECK(Equal(paragraph.get_lines(), LayOut(paragraph.get_text(), 1000.0f)));
+    CHECK(paragraph.get_relaid_line_count() == 3);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,226 @@
+#include "stream_buffer.hpp"
+#include "test.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/* Hands out plain memory & numbered fences, and records every call in order. */
+class MockStreamBufferDevice : public StreamBufferDevice
+{
+public:
+    enum class CallType
+    {
+        MapStorage,
+        ReleaseStorage,
+        InsertFence,
+        WaitFence,
+        DeleteFence,
+    };
+
+    struct Call
+    {
+        CallType type{};
+        Fence fence{};
+        std::size_t size{};
+
+        auto operator==(const Call&) const -> bool = default;
+    };
+
+    auto map_storage(std::size_t size) -> std::uint8_t* override
+    {
+        calls.push_back({ CallType::MapStorage, nullptr, size });
+        if (failMapping)
+        {
+            return nullptr;
+        }
+        storage.resize(size);
+        return storage.data();
+    }
+
+    void release_storage() override
+    {
+        calls.push_back({ CallType::ReleaseStorage });
+        storage.clear();
+    }
+
+    auto insert_fence() -> Fence override
+    {
+        const auto fence = Fence(std::uintptr_t(++fenceCount));
+        calls.push_back({ CallType::InsertFence, fence });
+        ++liveFences;
+        return fence;
+    }
+
+    void wait_fence(Fence fence) override { calls.push_back({ CallType::WaitFence, fence }); }
+
+    void delete_fence(Fence fence) override
+    {
+        calls.push_back({ CallType::DeleteFence, fence });
+        --liveFences;
+    }
+
+    std::vector<Call> calls{};
+    std::vector<std::uint8_t> storage{};
+    std::uintptr_t fenceCount{};
+    std::int32_t liveFences{};
+    bool failMapping{ false };
+};
+
+using Call = MockStreamBufferDevice::Call;
+using CallType = MockStreamBufferDevice::CallType;
+
+/* The fence the mock returned from its `number`th insert_fence. */
+static auto MockFence(std::uintptr_t number) -> StreamBufferDevice::Fence
+{
+    return StreamBufferDevice::Fence(number);
+}
+
+TEST_CASE(maps_every_frame_up_front)
+{
+    MockStreamBufferDevice device{};
+    {
+        StreamBuffer buffer(device, 256);
+        CHECK(device.calls.size() == 1);
+        CHECK((device.calls[0] == Call{ CallType::MapStorage, nullptr, 256 * STREAM_BUFFER_FRAME_COUNT }));
+        CHECK(buffer.get_frame_size() == 256);
+
+        // Nothing fits until the first frame begins.
+        CHECK(buffer.reserve(1) == nullptr);
+    }
+    CHECK(device.calls.back().type == CallType::ReleaseStorage);
+    CHECK(device.storage.empty());
+}
+
+TEST_CASE(rejects_empty_frames_and_failed_mappings)
+{
+    MockStreamBufferDevice device{};
+    CHECK_THROWS(StreamBuffer(device, 0));
+
+    device.failMapping = true;
+    CHECK_THROWS(StreamBuffer(device, 64));
+}
+
+TEST_CASE(wraps_around_and_waits_on_the_reused_region)
+{
+    MockStreamBufferDevice device{};
+    StreamBuffer buffer(device, 100);
+    device.calls.clear();
+
+    // The first pass over the ring finds every region idle.
+    for (std::uint32_t frame = 0; frame < STREAM_BUFFER_FRAME_COUNT; ++frame)
+    {
+        buffer.begin_frame();
+        CHECK(buffer.get_frame_offset() == frame * 100);
+        CHECK(buffer.get_frame_used() == 0);
+        buffer.end_frame();
+    }
+    CHECK(device.calls.size() == STREAM_BUFFER_FRAME_COUNT);
+    for (const auto& call : device.calls)
+    {
+        CHECK(call.type == CallType::InsertFence);
+    }
+
+    // Back at the first region, which is only reused once the fence of the first frame is signalled.
+    device.calls.clear();
+    buffer.begin_frame();
+    CHECK(buffer.get_frame_offset() == 0);
+    CHECK(device.calls.size() == 2);
+    CHECK((device.calls[0] == Call{ CallType::WaitFence, MockFence(1) }));
+    CHECK((device.calls[1] == Call{ CallType::DeleteFence, MockFence(1) }));
+    buffer.end_frame();
+
+    device.calls.clear();
+    buffer.begin_frame();
+    CHECK(buffer.get_frame_offset() == 100);
+    CHECK(device.calls.size() == 2);
+    CHECK((device.calls[0] == Call{ CallType::WaitFence, MockFence(2) }));
+    CHECK((device.calls[1] == Call{ CallType::DeleteFence, MockFence(2) }));
+}
+
+TEST_CASE(end_frame_without_begin_frame_replaces_the_fence)
+{
+    MockStreamBufferDevice device{};
+    {
+        StreamBuffer buffer(device, 100);
+        buffer.begin_frame();
+        buffer.end_frame();
+        device.calls.clear();
+
+        buffer.end_frame();
+        CHECK(device.calls.size() == 2);
+        CHECK((device.calls[0] == Call{ CallType::DeleteFence, MockFence(1) }));
+        CHECK((device.calls[1] == Call{ CallType::InsertFence, MockFence(2) }));
+        CHECK(device.liveFences == 1);
+
+        // Reusing the region waits on the replacement.
+        for (std::uint32_t frame = 0; frame < STREAM_BUFFER_FRAME_COUNT; ++frame)
+        {
+            buffer.begin_frame();
+        }
+        CHECK(buffer.get_frame_offset() == 0);
+        CHECK((device.calls[device.calls.size() - 2] == Call{ CallType::WaitFence, MockFence(2) }));
+        buffer.end_frame();
+    }
+
+    // Fences still in flight are deleted with the buffer.
+    CHECK(device.liveFences == 0);
+}
+
+TEST_CASE(reserves_aligned_ranges_within_the_frame)
+{
+    MockStreamBufferDevice device{};
+    StreamBuffer buffer(device, 100);
+    buffer.begin_frame();
+    buffer.end_frame();
+    buffer.begin_frame();
+    const auto frameOffset = buffer.get_frame_offset();
+    CHECK(frameOffset == 100);
+
+    auto* data = buffer.reserve(10);
+    CHECK(data == device.storage.data() + frameOffset);
+    CHECK(buffer.get_reserved_offset() == frameOffset);
+    buffer.commit(3);
+    CHECK(buffer.get_frame_used() == 3);
+
+    // Aligned from the start of the storage, as GPU offsets are.
+    data = buffer.reserve(8, 16);
+    CHECK(buffer.get_reserved_offset() == 112);
+    CHECK(data == device.storage.data() + 112);
+    buffer.commit(8);
+    CHECK(buffer.get_frame_used() == 20);
+
+    // Reservations may be larger than the commit, only the commit is allocated.
+    CHECK(buffer.reserve(80) != nullptr);
+    buffer.commit(0);
+    CHECK(buffer.get_frame_used() == 20);
+
+    // Up to the end of the frame fits, one byte more or an alignment past it doesn't.
+    CHECK(buffer.reserve(81) == nullptr);
+    CHECK(buffer.reserve(1, 256) == nullptr);
+    CHECK(buffer.reserve(80) == device.storage.data() + 120);
+    buffer.commit(80);
+    CHECK(buffer.get_frame_used() == 100);
+    CHECK(buffer.reserve(1) == nullptr);
+}
+
+TEST_CASE(commit_throws_past_the_reservation)
+{
+    MockStreamBufferDevice device{};
+    StreamBuffer buffer(device, 100);
+    buffer.begin_frame();
+
+    CHECK(buffer.reserve(16) != nullptr);
+    CHECK_THROWS(buffer.commit(17));
+    buffer.commit(16);
+
+    // A reservation is committed once, and a failed one leaves nothing to commit.
+    CHECK_THROWS(buffer.commit(1));
+    CHECK(buffer.reserve(1000) == nullptr);
+    CHECK_THROWS(buffer.commit(1));
+    CHECK(buffer.get_frame_used() == 16);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdio>
+#include <exception>
+#include <vector>
+
+/* A minimal test harness, so the tests build without anything beyond the standard library. */
+struct TestCase
+{
+    const char* name;
+    void (*func)();
+};
+
+inline auto get_test_cases() -> std::vector<TestCase>&
+{
+    static std::vector<TestCase> cases{};
+    return cases;
+}
+
+inline auto get_test_failures() -> int&
+{
+    static int failures = 0;
+    return failures;
+}
+
+struct TestRegistration
+{
+    TestRegistration(const char* name, void (*func)()) { get_test_cases().push_back({ name, func }); }
+};
+
+#define TEST_CASE(name)                                              \
+    static void name();                                              \
+    static const TestRegistration name##Registration{ #name, name }; \
+    static void name()
+
+#define CHECK(condition)                                                              \
+    do                                                                                \
+    {                                                                                 \
+        if (!(condition))                                                             \
+        {                                                                             \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++get_test_failures();                                                    \
+        }                                                                             \
+    } while (false)
+
+#define CHECK_THROWS(expression)                                                                    \
+    do                                                                                              \
+    {                                                                                               \
+        bool threw = false;                                                                         \
+        try                                                                                         \
+        {                                                                                           \
+            expression;                                                                             \
+        }                                                                                           \
+        catch (...)                                                                                 \
+        {                                                                                           \
+            threw = true;                                                                           \
+        }                                                                                           \
+        if (!threw)                                                                                 \
+        {                                                                                           \
+            std::printf("%s:%d: CHECK_THROWS(%s) didn't throw\n", __FILE__, __LINE__, #expression); \
+            ++get_test_failures();                                                                  \
+        }                                                                                           \
+    } while (false)
+
+/* Runs every TEST_CASE, returns the process exit code. */
+inline auto run_tests() -> int
+{
+    for (const auto& test : get_test_cases())
+    {
+        const auto failures = get_test_failures();
+        try
+        {
+            test.func();
+        }
+        catch (const std::exception& e)
+        {
+            std::printf("%s threw: %s\n", test.name, e.what());
+            ++get_test_failures();
+        }
+        std::printf("%s %s\n", get_test_failures() == failures ? "PASS" : "FAIL", test.name);
+    }
+    return get_test_failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+#include "font.hpp"
+#include "text_batch.hpp"
+#include "text_render_backend.hpp"
+#include "test.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+/* Generated eagerly & without the atlas cache, so every run lays out the same glyphs. */
+static auto MakeTestConfig(AtlasType atlasType) -> FontConfig
+{
+    FontConfig config{};
+    config.atlasType = atlasType;
+    config.cacheDirectory.clear();
+    return config;
+}
+
+static auto GetMsdfFont() -> Font&
+{
+    static Font font(std::filesystem::path(TEST_FONT_DIRECTORY) / "OpenSans-Regular.ttf", MakeTestConfig(AtlasType::MSDF));
+    return font;
+}
+
+static auto GetMtsdfFont() -> Font&
+{
+    static Font font(std::filesystem::path(TEST_FONT_DIRECTORY) / "OpenSans-Bold.ttf", MakeTestConfig(AtlasType::MTSDF));
+    return font;
+}
+
+/* The instances of `draw` in the order they are uploaded. */
+static auto GatherDraw(const TextDrawList& drawList, const TextDraw& draw) -> std::vector<GlyphInstance>
+{
+    std::vector<GlyphInstance> instances(draw.instanceCount);
+    drawList.gather(draw, instances.data());
+    return instances;
+}
+
+TEST_CASE(splits_draws_by_shader_atlas_and_scissor)
+{
+    auto& msdf = GetMsdfFont();
+    auto& mtsdf = GetMtsdfFont();
+
+    // Every string gets its own color, so the instances can be traced back to it. Each letter is one instance.
+    TextBatch batch{};
+    batch.add_text(mtsdf, 0.0f, 0.0f, "ab", 20.0f, 1);
+    batch.add_text(msdf, 0.0f, 30.0f, "cd", 20.0f, 2);
+    batch.set_scissor({ 0, 0, 400, 400 });
+    batch.add_text(msdf, 0.0f, 60.0f, "ef", 20.0f, 3);
+    batch.reset_scissor();
+    batch.add_text(msdf, 100.0f, 0.0f, "gh", 20.0f, 4);
+    batch.add_text(mtsdf, 100.0f, 30.0f, "ij", 20.0f, 5);
+    CHECK(batch.get_instance_count() == 10);
+
+    TextDrawList drawList{};
+    batch.build_draw_list(drawList);
+    CHECK(batch.get_instance_count() == 0);
+
+    RecordingTextBackend backend{};
+    backend.begin_frame();
+    backend.render(drawList, 800, 600);
+    backend.end_frame();
+    CHECK(backend.get_frame_count() == 1);
+    CHECK(backend.get_draw_count() == 3);
+    CHECK(backend.get_instance_count() == 10);
+    CHECK(backend.get_recordings().size() == 1);
+    if (backend.get_recordings().size() != 1)
+    {
+        return;
+    }
+
+    const auto& recording = backend.get_recordings()[0];
+    CHECK(recording.frame == 0);
+    CHECK(recording.viewportWidth == 800);
+    CHECK(recording.viewportHeight == 600);
+
+    // MSDF atlases use the three channel shader, which sorts first, then no scissor before the first scissor rect.
+    const auto& recorded = recording.drawList;
+    CHECK(recorded.instances.size() == 10);
+    CHECK(recorded.scissors.size() == 1);
+    CHECK(recorded.draws.size() == 3);
+    if (recorded.draws.size() != 3)
+    {
+        return;
+    }
+
+    struct ExpectedDraw
+    {
+        Font* font;
+        std::uint32_t scissor;
+        std::uint32_t firstInstance;
+        std::vector<TextInstanceRange> ranges;
+        std::vector<std::uint32_t> colors;
+    };
+    const ExpectedDraw expected[] = {
+        { &msdf, TEXT_NO_SCISSOR, 0, { { 2, 2 }, { 6, 2 } }, { 2, 2, 4, 4 } },
+        { &msdf, 0, 4, { { 4, 2 } }, { 3, 3 } },
+        { &mtsdf, TEXT_NO_SCISSOR, 6, { { 0, 2 }, { 8, 2 } }, { 1, 1, 5, 5 } },
+    };
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        const auto& draw = recorded.draws[i];
+        CHECK(recorded.atlases[draw.atlas] == expected[i].font);
+        CHECK(draw.scissor == expected[i].scissor);
+        CHECK(draw.firstInstance == expected[i].firstInstance);
+        CHECK(draw.instanceCount == expected[i].colors.size());
+        CHECK(draw.rangeCount == expected[i].ranges.size());
+        for (std::size_t range = 0; range < draw.rangeCount && range < expected[i].ranges.size(); ++range)
+        {
+            CHECK(recorded.ranges[draw.firstRange + range].first == expected[i].ranges[range].first);
+            CHECK(recorded.ranges[draw.firstRange + range].count == expected[i].ranges[range].count);
+        }
+
+        // Strings of a draw keep the order they were added in, and their glyphs run left to right.
+        const auto instances = GatherDraw(recorded, draw);
+        for (std::size_t instance = 0; instance < instances.size() && instance < expected[i].colors.size(); ++instance)
+        {
+            CHECK(instances[instance].color == expected[i].colors[instance]);
+            if (instance > 0 && instances[instance].color == instances[instance - 1].color)
+            {
+                CHECK(instances[instance].x > instances[instance - 1].x);
+            }
+        }
+    }
+    CHECK(recorded.scissors[0] == (ScissorRect{ 0, 0, 400, 400 }));
+}
+
+TEST_CASE(merges_strings_added_in_order)
+{
+    auto& msdf = GetMsdfFont();
+
+    TextBatch batch{};
+    batch.add_text(msdf, 0.0f, 0.0f, "abc", 20.0f, 1);
+    batch.add_text(msdf, 0.0f, 30.0f, "de", 20.0f, 2);
+
+    TextDrawList drawList{};
+    batch.build_draw_list(drawList);
+    CHECK(drawList.draws.size() == 1);
+    CHECK(drawList.ranges.size() == 1);
+    if (drawList.draws.size() != 1 || drawList.ranges.size() != 1)
+    {
+        return;
+    }
+    CHECK(drawList.draws[0].instanceCount == 5);
+    CHECK(drawList.ranges[0].first == 0);
+    CHECK(drawList.ranges[0].count == 5);
+
+    // The golden output of a layout is stable between runs.
+    batch.add_text(msdf, 0.0f, 0.0f, "abc", 20.0f, 1);
+    batch.add_text(msdf, 0.0f, 30.0f, "de", 20.0f, 2);
+    TextDrawList again{};
+    batch.build_draw_list(again);
+    CHECK(again.instances.size() == drawList.instances.size());
+    for (std::size_t i = 0; i < again.instances.size() && i < drawList.instances.size(); ++i)
+    {
+        CHECK(std::memcmp(&again.instances[i], &drawList.instances[i], sizeof(GlyphInstance)) == 0);
+    }
+}
+
+TEST_CASE(culls_glyphs_outside_the_scissor_rect)
+{
+    auto& msdf = GetMsdfFont();
+
+    // The second line lies below the scissor rect, the first is cut at its right edge.
+    TextBatch batch{};
+    batch.set_viewport(800, 600);
+    batch.set_scissor({ 0, 0, 30, 40 });
+    batch.add_text(msdf, 0.0f, 0.0f, "abcdefgh", 20.0f, 1);
+    batch.add_text(msdf, 0.0f, 100.0f, "abcdefgh", 20.0f, 2);
+
+    TextDrawList drawList{};
+    batch.build_draw_list(drawList);
+    CHECK(!drawList.instances.empty());
+    CHECK(drawList.instances.size() < 8);
+    for (const auto& instance : drawList.instances)
+    {
+        CHECK(instance.color == 1);
+        CHECK(instance.x >= 0);
+        CHECK(instance.x + instance.width <= 30);
+        CHECK(instance.y + instance.height <= 40);
+    }
+}
+
+int main()
+{
+    return run_tests();
+}
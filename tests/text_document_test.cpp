@@ -0,0 +1,155 @@
+#include "fenwick_tree.hpp"
+#include "font.hpp"
+#include "text_document.hpp"
+#include "test.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+static auto GetFont() -> Font&
+{
+    FontConfig config{};
+    config.cacheDirectory.clear();
+    static Font font(std::filesystem::path(TEST_FONT_DIRECTORY) / "OpenSans-Regular.ttf", config);
+    return font;
+}
+
+/*
+ * How many values from the start add up to at most `target`, scanned one by one. The values are floats, which doubles
+ * add up exactly at these sizes, so the scan & the tree agree bit for bit whatever order they add in.
+ */
+static auto FindLinear(const std::vector<float>& values, double target) -> std::size_t
+{
+    double sum = 0.0;
+    std::size_t count = 0;
+    while (count < values.size() && sum + values[count] <= target)
+    {
+        sum += values[count];
+        ++count;
+    }
+    return count;
+}
+
+static auto PrefixSumLinear(const std::vector<float>& values, std::size_t count) -> double
+{
+    double sum = 0.0;
+    for (std::size_t i = 0; i < count && i < values.size(); ++i)
+    {
+        sum += values[i];
+    }
+    return sum;
+}
+
+/* A height in quarter pixels, a fifth of them zero. */
+static auto RandomHeight(std::mt19937& random) -> float
+{
+    return random() % 5 == 0 ? 0.0f : float(random() % 200) * 0.25f;
+}
+
+TEST_CASE(fenwick_tree_matches_a_linear_scan)
+{
+    std::mt19937 random(24);
+    for (std::size_t size : { 0, 1, 2, 3, 5, 7, 8, 9, 31, 33, 100, 257 })
+    {
+        FenwickTree tree{};
+        std::vector<float> values{};
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            values.push_back(RandomHeight(random));
+            tree.push_back(values.back());
+        }
+
+        for (std::int32_t i = 0; i < 200; ++i)
+        {
+            if (!values.empty() && random() % 2)
+            {
+                const auto index = random() % values.size();
+                const auto value = RandomHeight(random);
+                tree.add(index, double(value) - double(values[index]));
+                values[index] = value;
+            }
+
+            CHECK(tree.size() == values.size());
+            CHECK(tree.total() == PrefixSumLinear(values, values.size()));
+            const auto count = random() % (values.size() + 2);
+            CHECK(tree.prefix_sum(count) == PrefixSumLinear(values, count));
+
+            // Targets anywhere, exactly on the sums, in front of the first value & past the last one.
+            const auto boundary = PrefixSumLinear(values, random() % (values.size() + 1));
+            for (double target : { double(random() % 10000) * 0.125, boundary, boundary - 0.125, -1.0, tree.total() + 1.0 })
+            {
+                CHECK(tree.find(target) == FindLinear(values, target));
+            }
+        }
+
+        tree.clear();
+        CHECK(tree.size() == 0);
+        CHECK(tree.find(10.0) == 0);
+    }
+}
+
+TEST_CASE(find_line_matches_a_linear_scan)
+{
+    TextDocument document(GetFont(), 16.0f);
+    std::vector<float> heights{};
+    std::mt19937 random(42);
+    for (std::int32_t i = 0; i < 77; ++i)
+    {
+        document.append_line("line " + std::to_string(i));
+        heights.push_back(document.get_line_height(std::size_t(i)));
+    }
+    CHECK(document.get_line_height(0) > 0.0f);
+
+    // The line at y is the one after all the lines ending at or above it, zero high lines included.
+    const auto expectedLine = [&](float y) -> std::size_t
+    {
+        return y < 0.0f ? 0 : std::min(FindLinear(heights, double(y)), heights.size() - 1);
+    };
+
+    for (std::int32_t i = 0; i < 500; ++i)
+    {
+        const auto index = random() % heights.size();
+        const auto height = RandomHeight(random);
+        document.set_line_height(index, height);
+        heights[index] = height;
+        CHECK(document.get_line_height(index) == height);
+        CHECK(document.get_height() == float(PrefixSumLinear(heights, heights.size())));
+
+        // A scroll offset exactly on the top of a line, just above it, anywhere & outside the document.
+        const auto line = random() % heights.size();
+        const auto top = document.get_line_top(line);
+        CHECK(top == float(PrefixSumLinear(heights, line)));
+        for (float y : { top, top - 0.125f, float(random() % 8000) * 0.25f, -0.25f, document.get_height() + 1.0f })
+        {
+            CHECK(document.find_line(y) == expectedLine(y));
+        }
+    }
+
+    // A boundary with lines on either side is found as the line below it.
+    for (std::size_t i = 0; i < document.get_line_count(); ++i)
+    {
+        document.set_line_height(i, 10.0f);
+    }
+    CHECK(document.find_line(30.0f) == 3);
+    CHECK(document.find_line(29.75f) == 2);
+    CHECK(document.find_line(document.get_height()) == document.get_line_count() - 1);
+
+    // Zero high lines at the boundary are passed over to the first line with height.
+    document.set_line_height(3, 0.0f);
+    document.set_line_height(4, 0.0f);
+    CHECK(document.find_line(30.0f) == 5);
+    CHECK(document.get_line_top(5) == 30.0f);
+
+    document.clear();
+    CHECK(document.get_line_count() == 0);
+    CHECK(document.get_height() == 0.0f);
+    CHECK(document.find_line(5.0f) == 0);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,273 @@
+#include "font.hpp"
+#include "text_instances.hpp"
+#include "test.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+// The instance buffer layout the vertex attributes are set up for.
+static_assert(sizeof(GlyphInstance) == 20);
+static_assert(offsetof(GlyphInstance, x) == 0 && offsetof(GlyphInstance, y) == 2);
+static_assert(offsetof(GlyphInstance, width) == 4 && offsetof(GlyphInstance, height) == 6);
+static_assert(offsetof(GlyphInstance, u0) == 8 && offsetof(GlyphInstance, v0) == 10);
+static_assert(offsetof(GlyphInstance, u1) == 12 && offsetof(GlyphInstance, v1) == 14);
+static_assert(offsetof(GlyphInstance, color) == 16);
+
+static auto GetFont() -> Font&
+{
+    FontConfig config{};
+    config.cacheDirectory.clear();
+    static Font font(std::filesystem::path(TEST_FONT_DIRECTORY) / "OpenSans-Regular.ttf", config);
+    return font;
+}
+
+/* The instances `text` should lay out as, worked out from the glyph table without write_text_instances. */
+static auto LayOut(Font& font, float x, float y, std::string_view text, float fontSize, std::uint32_t color) -> std::vector<GlyphInstance>
+{
+    const auto scale = font.get_font_scale(fontSize);
+    y += font.get_font_info().Ascender * scale;
+
+    std::vector<GlyphInstance> instances{};
+    const GlyphInfo* previous = nullptr;
+    for (char c : text)
+    {
+        const auto* glyph = font.get_glyph_info(c == '\t' ? ' ' : std::uint8_t(c));
+        if (!glyph)
+        {
+            glyph = font.get_glyph_info('?');
+        }
+        if (previous)
+        {
+            x += scale * (previous->AdvanceX + font.get_kerning(*previous, *glyph));
+        }
+        previous = glyph;
+
+        const auto& quad = glyph->Quad;
+        const auto left = std::floor(x + quad.X0 * scale);
+        const auto bottom = std::floor(y + quad.Y0 * scale);
+        const auto right = std::floor(x + quad.X1 * scale);
+        const auto top = std::floor(y + quad.Y1 * scale);
+        if (right > left && bottom > top)
+        {
+            instances.push_back({ std::int16_t(left),
+                                  std::int16_t(top),
+                                  std::uint16_t(right - left),
+                                  std::uint16_t(bottom - top),
+                                  std::uint16_t(quad.U0 * 65535.0f + 0.5f),
+                                  std::uint16_t(quad.V0 * 65535.0f + 0.5f),
+                                  std::uint16_t(quad.U1 * 65535.0f + 0.5f),
+                                  std::uint16_t(quad.V1 * 65535.0f + 0.5f),
+                                  color });
+        }
+    }
+    return instances;
+}
+
+static auto operator==(const GlyphInstance& a, const GlyphInstance& b) -> bool
+{
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height && a.u0 == b.u0 && a.v0 == b.v0 && a.u1 == b.u1
+        && a.v1 == b.v1 && a.color == b.color;
+}
+
+TEST_CASE(writes_an_instance_per_visible_glyph)
+{
+    auto& font = GetFont();
+    const std::string_view text = "AVo Ty,\tfg";
+    const auto color = pack_color(1.0f, 0.5f, 0.0f, 1.0f);
+    CHECK(color == 0xFF0080FF);
+
+    // Space & tab have no quad, every other glyph gets one.
+    std::vector<GlyphInstance> instances(text.size());
+    const auto count = write_text_instances(instances.data(), font, 10.25f, 5.5f, text, 24.0f, color);
+    instances.resize(count);
+    const auto expected = LayOut(font, 10.25f, 5.5f, text, 24.0f, color);
+    CHECK(count == text.size() - 2);
+    CHECK(instances.size() == expected.size());
+    for (std::size_t i = 0; i < instances.size() && i < expected.size(); ++i)
+    {
+        CHECK(instances[i] == expected[i]);
+    }
+
+    // The quads lie within the line, give or take the distance field padding, and run left to right.
+    const auto& info = font.get_font_info();
+    const auto scale = font.get_font_scale(24.0f);
+    for (std::size_t i = 0; i < instances.size(); ++i)
+    {
+        CHECK(instances[i].width > 0 && instances[i].height > 0);
+        CHECK(instances[i].y >= 5.5f - 6.0f);
+        CHECK(instances[i].y + instances[i].height <= 5.5f + (info.Ascender - info.Descender) * scale + 6.0f);
+        CHECK(instances[i].u0 < instances[i].u1);
+        if (i > 0)
+        {
+            CHECK(instances[i].x > instances[i - 1].x);
+        }
+    }
+    if (!instances.empty())
+    {
+        CHECK(instances[0].x == std::int16_t(std::floor(10.25f + font.get_glyph_info('A')->Quad.X0 * scale)));
+    }
+}
+
+TEST_CASE(draws_missing_codepoints_as_question_marks)
+{
+    auto& font = GetFont();
+    CHECK(font.get_glyph_info(0x4E2D) == nullptr);
+
+    std::vector<GlyphInstance> missing(8);
+    std::vector<GlyphInstance> question(8);
+    CHECK(write_text_instances(missing.data(), font, 0.0f, 0.0f, "a\xE4\xB8\xAD" "b", 16.0f, 1) == 3);
+    CHECK(write_text_instances(question.data(), font, 0.0f, 0.0f, "a?b", 16.0f, 1) == 3);
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        CHECK(missing[i] == question[i]);
+    }
+}
+
+TEST_CASE(appends_after_existing_instances)
+{
+    auto& font = GetFont();
+    std::vector<GlyphInstance> instances{};
+    CHECK(append_text_instances(instances, font, 0.0f, 0.0f, "ab", 16.0f, 1) == 2);
+    CHECK(append_text_instances(instances, font, 0.0f, 20.0f, " \t ", 16.0f, 2) == 0);
+    CHECK(append_text_instances(instances, font, 0.0f, 20.0f, "c d", 16.0f, 3) == 2);
+    CHECK(instances.size() == 4);
+
+    const auto first = LayOut(font, 0.0f, 0.0f, "ab", 16.0f, 1);
+    const auto second = LayOut(font, 0.0f, 20.0f, "c d", 16.0f, 3);
+    CHECK(first.size() == 2 && second.size() == 2);
+    if (instances.size() == 4 && first.size() == 2 && second.size() == 2)
+    {
+        CHECK(instances[0] == first[0]);
+        CHECK(instances[1] == first[1]);
+        CHECK(instances[2] == second[0]);
+        CHECK(instances[3] == second[1]);
+    }
+}
+
+TEST_CASE(clips_each_edge_and_moves_its_texture_coordinates)
+{
+    // 100 x 50 pixels at (10, 20), u from 1000 on the left to 11000, v from 3000 on the top to 5000 on the bottom.
+    const GlyphInstance quad{ 10, 20, 100, 50, 1000, 5000, 11000, 3000, 7 };
+
+    auto clipped = quad;
+    CHECK(clip_glyph_instance(clipped, { 35, -32768, 32768, 32768 }));
+    CHECK(clipped == GlyphInstance({ 35, 20, 75, 50, 3500, 5000, 11000, 3000, 7 }));
+
+    clipped = quad;
+    CHECK(clip_glyph_instance(clipped, { -32768, -32768, 85, 32768 }));
+    CHECK(clipped == GlyphInstance({ 10, 20, 75, 50, 1000, 5000, 8500, 3000, 7 }));
+
+    // The top edge samples v1, so cutting it moves v1 & cutting the bottom moves v0.
+    clipped = quad;
+    CHECK(clip_glyph_instance(clipped, { -32768, 30, 32768, 32768 }));
+    CHECK(clipped == GlyphInstance({ 10, 30, 100, 40, 1000, 5000, 11000, 3400, 7 }));
+
+    clipped = quad;
+    CHECK(clip_glyph_instance(clipped, { -32768, -32768, 32768, 60 }));
+    CHECK(clipped == GlyphInstance({ 10, 20, 100, 40, 1000, 4600, 11000, 3000, 7 }));
+
+    // All four edges at once, to a single pixel. Fractions round to the nearest coordinate.
+    clipped = quad;
+    CHECK(clip_glyph_instance(clipped, { 43, 27, 44, 28 }));
+    CHECK(clipped == GlyphInstance({ 43, 27, 1, 1, 4300, 3320, 4400, 3280, 7 }));
+    clipped = { 0, 0, 3, 7, 0, 65535, 65535, 0, 7 };
+    CHECK(clip_glyph_instance(clipped, { 1, 1, 32768, 32768 }));
+    CHECK(clipped == GlyphInstance({ 1, 1, 2, 6, 21845, 65535, 65535, 9362, 7 }));
+
+    // Within the rect nothing changes. Right & bottom edges are exclusive, a quad just outside any edge is rejected as is.
+    clipped = quad;
+    CHECK(clip_glyph_instance(clipped, { 10, 20, 110, 70 }));
+    CHECK(clipped == quad);
+    CHECK(clip_glyph_instance(clipped, TextClipRect{}));
+    CHECK(clipped == quad);
+    for (const auto& outside : { TextClipRect{ 110, 0, 200, 100 }, TextClipRect{ 0, 70, 200, 100 }, TextClipRect{ 0, 0, 10, 100 },
+                                 TextClipRect{ 0, 0, 200, 20 }, TextClipRect{ 50, 40, 50, 60 } })
+    {
+        CHECK(!clip_glyph_instance(clipped, outside));
+        CHECK(clipped == quad);
+    }
+}
+
+TEST_CASE(clipped_lines_match_clipping_every_glyph)
+{
+    auto& font = GetFont();
+    const std::string_view text = "AVo Ty,\tfg";
+    const auto unclipped = LayOut(font, 10.25f, 5.5f, text, 24.0f, 1);
+
+    // Rects cutting the line on every side, the right edge at every pixel. The early outs must not drop a glyph clipping
+    // would keep, e.g. one whose distance field padding reaches back over the edge.
+    for (std::int32_t left : { -100, 0, 20, 57, 200 })
+    {
+        for (std::int32_t top : { -100, 0, 9, 20, 40 })
+        {
+            for (std::int32_t right = 0; right <= 200; ++right)
+            {
+                for (std::int32_t bottom : { -20, 5, 16, 30, 100 })
+                {
+                    const TextClipRect clip{ left, top, right, bottom };
+                    std::vector<GlyphInstance> expected{};
+                    for (auto instance : unclipped)
+                    {
+                        if (clip_glyph_instance(instance, clip))
+                        {
+                            expected.push_back(instance);
+                        }
+                    }
+
+                    std::vector<GlyphInstance> instances{};
+                    CHECK(append_text_instances(instances, font, 10.25f, 5.5f, text, 24.0f, 1, &clip) == expected.size());
+                    CHECK(instances.size() == expected.size());
+                    for (std::size_t i = 0; i < instances.size() && i < expected.size(); ++i)
+                    {
+                        CHECK(instances[i] == expected[i]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(skips_lines_and_glyphs_outside_the_clip_rect)
+{
+    auto& font = GetFont();
+    const GlyphInstance unwritten{ -1, -1, 1, 1, 1, 1, 1, 1, 0xDEADBEEF };
+
+    // A line at y = 100 of 16 pixels is rejected as a whole once it is half the font size or more away from the rect,
+    // before a single instance is written. Any nearer, its glyphs are written & cut away one by one.
+    const auto writtenFirst = [&](const TextClipRect& clip) -> bool
+    {
+        std::vector<GlyphInstance> instances(3, unwritten);
+        CHECK(write_text_instances(instances.data(), font, 0.0f, 100.0f, "abc", 16.0f, 1, &clip) == 0);
+        return !(instances[0] == unwritten);
+    };
+    CHECK(!writtenFirst({ -32768, -32768, 32768, 92 }));
+    CHECK(writtenFirst({ -32768, -32768, 32768, 93 }));
+    CHECK(!writtenFirst({ -32768, 124, 32768, 32768 }));
+    CHECK(writtenFirst({ -32768, 123, 32768, 32768 }));
+
+    // The line stops at the first glyph starting half the font size past the right edge, the ones after it aren't
+    // written at all. Without the early out 'c' would be written after "ab" & cut away.
+    const std::string_view text = "ab        cd";
+    const auto unclipped = LayOut(font, 0.0f, 0.0f, text, 16.0f, 1);
+    CHECK(unclipped.size() == 4);
+    if (unclipped.size() == 4)
+    {
+        const TextClipRect clip{ -32768, -32768, unclipped[1].x + unclipped[1].width, 32768 };
+        CHECK(unclipped[2].x >= clip.right + 8);
+
+        std::vector<GlyphInstance> instances(text.size(), unwritten);
+        CHECK(write_text_instances(instances.data(), font, 0.0f, 0.0f, text, 16.0f, 1, &clip) == 2);
+        CHECK(instances[0] == unclipped[0]);
+        CHECK(instances[1] == unclipped[1]);
+        CHECK(instances[2] == unwritten);
+    }
+}
+
+int main()
+{
+    return run_tests();
+}
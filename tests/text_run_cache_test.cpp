@@ -0,0 +1,90 @@
+#include "font.hpp"
+#include "text_run_cache.hpp"
+#include "test.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+static auto MakeTestConfig() -> FontConfig
+{
+    FontConfig config{};
+    config.cacheDirectory.clear();
+    return config;
+}
+
+static auto GetFontPath(const char* filename) -> std::filesystem::path
+{
+    return std::filesystem::path(TEST_FONT_DIRECTORY) / filename;
+}
+
+static auto Equal(std::span<const GlyphInstance> a, std::span<const GlyphInstance> b) -> bool
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+}
+
+TEST_CASE(reuses_runs_of_the_same_font_size_and_string)
+{
+    Font font(GetFontPath("OpenSans-Regular.ttf"), MakeTestConfig());
+    TextRunCache cache{};
+
+    std::vector<GlyphInstance> expected{};
+    append_text_instances(expected, font, 0.0f, 0.0f, "Hello", 16.0f, 0);
+    CHECK(Equal(cache.get(font, "Hello", 16.0f), expected));
+    CHECK(Equal(cache.get(font, "Hello", 16.0f), expected));
+    CHECK(cache.get_miss_count() == 1);
+    CHECK(cache.get_hit_count() == 1);
+
+    cache.get(font, "Hello", 20.0f);
+    cache.get(font, "Help", 16.0f);
+    CHECK(cache.get_miss_count() == 3);
+    CHECK(cache.get_entry_count() == 3);
+}
+
+TEST_CASE(tells_apart_fonts_at_the_same_address)
+{
+    // The second font is constructed in the storage the first one was freed from.
+    std::optional<Font> font{};
+    font.emplace(GetFontPath("OpenSans-Regular.ttf"), MakeTestConfig());
+    const auto* address = &*font;
+    const auto firstId = font->get_id();
+
+    TextRunCache cache{};
+    cache.get(*font, "Hello", 16.0f);
+    font.reset();
+    font.emplace(GetFontPath("OpenSans-Bold.ttf"), MakeTestConfig());
+    CHECK(&*font == address);
+    CHECK(font->get_id() != firstId);
+
+    std::vector<GlyphInstance> expected{};
+    append_text_instances(expected, *font, 0.0f, 0.0f, "Hello", 16.0f, 0);
+    CHECK(Equal(cache.get(*font, "Hello", 16.0f), expected));
+    CHECK(cache.get_miss_count() == 2);
+    CHECK(cache.get_hit_count() == 0);
+
+    // The freed font's run is never looked up again, it ages out like any other.
+    CHECK(cache.get_entry_count() == 2);
+}
+
+TEST_CASE(keeps_runs_of_a_moved_font)
+{
+    Font font(GetFontPath("OpenSans-Regular.ttf"), MakeTestConfig());
+    TextRunCache cache{};
+    cache.get(font, "Hello", 16.0f);
+
+    // The glyphs move along with the id, so the runs laid out with them still apply.
+    Font moved(std::move(font));
+    cache.get(moved, "Hello", 16.0f);
+    Font assigned(GetFontPath("OpenSans-Bold.ttf"), MakeTestConfig());
+    assigned = std::move(moved);
+    cache.get(assigned, "Hello", 16.0f);
+    CHECK(cache.get_miss_count() == 1);
+    CHECK(cache.get_hit_count() == 2);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,218 @@
+#include "utf8_reader.hpp"
+#include "test.hpp"
+
+#include <utf8.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static auto Decode(std::string_view text) -> std::vector<std::uint32_t>
+{
+    std::vector<std::uint32_t> codepoints{};
+    Utf8Reader reader(text);
+    std::uint32_t codepoint{};
+    while (reader.next(codepoint))
+    {
+        codepoints.push_back(codepoint);
+    }
+    return codepoints;
+}
+
+/* What msdf_atlas::utf8Decode makes of `text`, which must not contain a null. */
+static auto DecodeReference(const std::string& text) -> std::vector<std::uint32_t>
+{
+    std::vector<msdf_atlas::unicode_t> codepoints{};
+    msdf_atlas::utf8Decode(codepoints, text.c_str());
+    return { codepoints.begin(), codepoints.end() };
+}
+
+static void Encode(std::string& out, std::uint32_t codepoint)
+{
+    if (codepoint < 0x80)
+    {
+        out += char(codepoint);
+    }
+    else if (codepoint < 0x800)
+    {
+        out += char(0xC0 | (codepoint >> 6));
+        out += char(0x80 | (codepoint & 0x3F));
+    }
+    else if (codepoint < 0x10000)
+    {
+        out += char(0xE0 | (codepoint >> 12));
+        out += char(0x80 | ((codepoint >> 6) & 0x3F));
+        out += char(0x80 | (codepoint & 0x3F));
+    }
+    else
+    {
+        out += char(0xF0 | (codepoint >> 18));
+        out += char(0x80 | ((codepoint >> 12) & 0x3F));
+        out += char(0x80 | ((codepoint >> 6) & 0x3F));
+        out += char(0x80 | (codepoint & 0x3F));
+    }
+}
+
+TEST_CASE(finds_the_end_of_ascii_runs)
+{
+    // Every length & start around the 16 byte blocks & the 8 byte tail, with one non-ASCII byte anywhere or none.
+    for (std::size_t size = 0; size <= 70; ++size)
+    {
+        for (std::size_t position = 0; position <= size; ++position)
+        {
+            std::string text(size, 'a');
+            if (position < size)
+            {
+                text[position] = char(0x80 | position);
+            }
+            for (std::size_t index = 0; index <= size; ++index)
+            {
+                const auto expected = index <= position ? position : size;
+                CHECK(find_ascii_end(text, index) == expected);
+            }
+        }
+    }
+
+    // Only the bytes within the view are looked at.
+    const std::string_view text = "0123456789abcdefghij\xC3\xA9";
+    CHECK(find_ascii_end(text.substr(0, 19), 0) == 19);
+    CHECK(find_ascii_end(text.substr(0, 20), 3) == 20);
+    CHECK(find_ascii_end(text, 4) == 20);
+}
+
+TEST_CASE(matches_utf8_decode_next_to_block_edges)
+{
+    // ASCII runs ending on either side of a 16 byte block boundary, then every length of sequence & more ASCII.
+    for (std::uint32_t codepoint : { 0xE9u, 0x7FFu, 0x800u, 0x20ACu, 0xFFFDu, 0xFFFFu, 0x10000u, 0x1F600u, 0x10FFFFu })
+    {
+        for (std::size_t runLength = 0; runLength <= 34; ++runLength)
+        {
+            std::string text(runLength, 'x');
+            Encode(text, codepoint);
+            text += std::string(runLength % 19, 'y');
+            Encode(text, codepoint);
+
+            const auto codepoints = Decode(text);
+            CHECK(codepoints == DecodeReference(text));
+            CHECK(codepoints.size() == runLength + 1 + runLength % 19 + 1);
+            if (codepoints.size() > runLength)
+            {
+                CHECK(codepoints[runLength] == codepoint);
+                CHECK(codepoints.back() == codepoint);
+            }
+        }
+    }
+}
+
+TEST_CASE(matches_utf8_decode_on_random_text)
+{
+    std::mt19937 random(20);
+    for (std::int32_t i = 0; i < 2000; ++i)
+    {
+        std::string text{};
+        std::vector<std::size_t> offsets{};  // The byte offset after every codepoint.
+        while (text.size() < 200)
+        {
+            // Mostly ASCII runs of any length, sometimes with control characters, else a sequence of any length.
+            if (random() % 2)
+            {
+                for (auto length = random() % 40; length > 0; --length)
+                {
+                    text += char(random() % 8 ? 0x20 + random() % 0x5F : 1 + random() % 0x7F);
+                    offsets.push_back(text.size());
+                }
+                continue;
+            }
+
+            std::uint32_t codepoint{};
+            switch (random() % 3)
+            {
+                case 0: codepoint = 0x80 + random() % (0x800 - 0x80); break;
+                case 1: codepoint = 0x800 + random() % (0x10000 - 0x800 - 0x800); break;
+                default: codepoint = 0x10000 + random() % (0x110000 - 0x10000); break;
+            }
+            if (codepoint >= 0xD800 && codepoint < 0x10000)
+            {
+                codepoint += 0x800;  // Skips the surrogates.
+            }
+            Encode(text, codepoint);
+            offsets.push_back(text.size());
+        }
+
+        CHECK(Decode(text) == DecodeReference(text));
+
+        Utf8Reader reader(text);
+        std::uint32_t codepoint{};
+        std::size_t count = 0;
+        while (reader.next(codepoint))
+        {
+            CHECK(count < offsets.size() && reader.get_offset() == offsets[count]);
+            ++count;
+        }
+        CHECK(count == offsets.size());
+    }
+}
+
+TEST_CASE(replaces_malformed_sequences)
+{
+    // utf8Decode drops or misreads these, the reader replaces every malformed sequence & keeps the bytes after it.
+    constexpr auto R = UTF8_REPLACEMENT_CHARACTER;
+    const struct
+    {
+        std::string_view text;
+        std::vector<std::uint32_t> codepoints;
+    } cases[] = {
+        // Stray continuation & invalid lead bytes.
+        { "\x80" "a", { R, 'a' } },
+        { "\xBF\x80", { R, R } },
+        { "\xFF" "a", { R, 'a' } },
+        { "\xF8\x88\x80\x80\x80", { R, R, R, R, R } },
+        // Truncated by the end of the text or by the next character.
+        { "a\xC3", { 'a', R } },
+        { "a\xE2\x82", { 'a', R } },
+        { "a\xF0\x9F\x98", { 'a', R } },
+        { "\xE2\x82" "a", { R, 'a' } },
+        { "\xF0\x9F\xE2\x82\xAC", { R, 0x20AC } },
+        { "\xC3\xC3\xA9", { R, 0xE9 } },
+        // Overlong encodings.
+        { "\xC0\xAF", { R } },
+        { "\xC1\xBF", { R } },
+        { "\xE0\x80\xAF", { R } },
+        { "\xE0\x9F\xBF", { R } },
+        { "\xF0\x80\x80\xAF", { R } },
+        { "\xF0\x8F\xBF\xBF", { R } },
+        // Surrogates & the codepoints around them.
+        { "\xED\x9F\xBF", { 0xD7FF } },
+        { "\xED\xA0\x80", { R } },
+        { "\xED\xBF\xBF", { R } },
+        { "\xEE\x80\x80", { 0xE000 } },
+        // Past the Unicode range.
+        { "\xF4\x8F\xBF\xBF", { 0x10FFFF } },
+        { "\xF4\x90\x80\x80", { R } },
+        { "\xF7\xBF\xBF\xBF", { R } },
+    };
+    for (const auto& [text, codepoints] : cases)
+    {
+        CHECK(Decode(text) == codepoints);
+
+        // Also straight after an ASCII run found by whole blocks, and cut off by the end of a longer buffer.
+        for (std::size_t runLength : { 15, 16, 17, 31 })
+        {
+            auto expected = std::vector<std::uint32_t>(runLength, 'x');
+            expected.insert(expected.end(), codepoints.begin(), codepoints.end());
+            CHECK(Decode(std::string(runLength, 'x') + std::string(text)) == expected);
+        }
+    }
+
+    const std::string_view euro = "\xE2\x82\xAC";
+    CHECK(Decode(euro.substr(0, 1)) == std::vector<std::uint32_t>{ R });
+    CHECK(Decode(euro.substr(0, 2)) == std::vector<std::uint32_t>{ R });
+    CHECK(Decode(euro) == std::vector<std::uint32_t>{ 0x20AC });
+}
+
+int main()
+{
+    return run_tests();
+}